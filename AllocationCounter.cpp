@@ -0,0 +1,46 @@
+#include "AllocationCounter.h"
+#include <cstdlib>
+#include <new>
+
+// The whole replaceable family, so that every form pairs malloc with free.
+// Kept in its own translation unit: inlined into the new expressions of
+// the test, GCC takes the free of a new-ed pointer for a mismatch.
+
+std::atomic<long> gAllocations(0);
+thread_local bool gCountAllocations = false;
+
+namespace {
+
+void *CountedAlloc(size_t size) noexcept {
+  if (gCountAllocations)
+    gAllocations++;
+  return malloc(size ? size : 1);
+}
+
+} // namespace
+
+void *operator new(size_t size) {
+  if (void *p = CountedAlloc(size))
+    return p;
+  throw std::bad_alloc();
+}
+void *operator new[](size_t size) {
+  if (void *p = CountedAlloc(size))
+    return p;
+  throw std::bad_alloc();
+}
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  return CountedAlloc(size);
+}
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+  return CountedAlloc(size);
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { free(p); }
+// the sized forms too: before C++14 they are only called from code built
+// with sized deallocation, the standard library among it
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
@@ -0,0 +1,20 @@
+#include <atomic>
+
+#pragma once
+
+// Heap allocations counted while enabled on the calling thread, through
+// the operator new/delete family replaced in AllocationCounter.cpp. Only
+// the test program links it.
+extern std::atomic<long> gAllocations;
+extern thread_local bool gCountAllocations;
+
+class PauseAllocationCount {
+public:
+  PauseAllocationCount() : mCounting(gCountAllocations) {
+    gCountAllocations = false;
+  }
+  ~PauseAllocationCount() { gCountAllocations = mCounting; }
+
+private:
+  bool mCounting;
+};
@@ -0,0 +1,276 @@
+#include "BufferedPersistentList.h"
+#include "PersistentList.h"
+#include <leveldb/write_batch.h>
+
+using namespace std;
+
+constexpr int BufferedPersistentList::MAX_BUFFER_FACTOR;
+
+std::string &BufferedPersistentList::Ring::PushFront() {
+  if (mCount == mSlots.size())
+    Grow();
+  mHead = (mHead - 1) & (mSlots.size() - 1);
+  mCount++;
+  return mSlots[mHead];
+}
+
+std::string &BufferedPersistentList::Ring::PushBack() {
+  if (mCount == mSlots.size())
+    Grow();
+  mCount++;
+  return At(mCount - 1);
+}
+
+void BufferedPersistentList::Ring::PopFront() {
+  mHead = (mHead + 1) & (mSlots.size() - 1);
+  mCount--;
+}
+
+void BufferedPersistentList::Ring::PopBack() { mCount--; }
+
+void BufferedPersistentList::Ring::Grow() {
+  // a power of two, so that indexes wrap with a mask
+  vector<string> slots(max<size_t>(16, 2 * mSlots.size()));
+  for (size_t i = 0; i < mCount; i++)
+    slots[i].swap(At(i));
+  mSlots.swap(slots);
+  mHead = 0;
+}
+
+std::shared_ptr<BufferedPersistentList>
+BufferedPersistentList::Get(std::shared_ptr<leveldb::DB> db,
+                            const std::string &listName, int flushItems,
+                            int flushIntervalMs) {
+  return std::shared_ptr<BufferedPersistentList>(
+      new BufferedPersistentList(db, listName, flushItems, flushIntervalMs));
+}
+
+BufferedPersistentList::BufferedPersistentList(std::shared_ptr<leveldb::DB> db,
+                                               const std::string &listName,
+                                               int flushItems,
+                                               int flushIntervalMs)
+    : mDB(db), mList(PersistentList::Get(db, listName)),
+      mFlushItems(max(1, flushItems)), mFlushInterval(flushIntervalMs),
+      mListEmpty(false), mStopping(false) {
+  mFlusher = thread(&BufferedPersistentList::FlushLoop, this);
+}
+
+BufferedPersistentList::~BufferedPersistentList() {
+  {
+    lock_guard<mutex> lock(mMutex);
+    mStopping = true;
+  }
+  mFlushCond.notify_one();
+  mFlusher.join();
+
+  lock_guard<mutex> lock(mMutex);
+  FlushLocked();
+}
+
+std::string BufferedPersistentList::Name() const { return mList->Name(); }
+
+int BufferedPersistentList::Size() const {
+  lock_guard<mutex> lock(mMutex);
+  return mFront.Size() + mList->Size() + mBack.Size();
+}
+
+int BufferedPersistentList::Buffered() const {
+  lock_guard<mutex> lock(mMutex);
+  return mFront.Size() + mBack.Size();
+}
+
+void BufferedPersistentList::PushFront(const leveldb::Slice &value) {
+  lock_guard<mutex> lock(mMutex);
+  mFront.PushFront().assign(value.data(), value.size());
+  Pushed();
+}
+
+void BufferedPersistentList::PushBack(const leveldb::Slice &value) {
+  lock_guard<mutex> lock(mMutex);
+  mBack.PushBack().assign(value.data(), value.size());
+  Pushed();
+}
+
+// Needs mMutex
+void BufferedPersistentList::Pushed() {
+  size_t buffered = mFront.Size() + mBack.Size();
+
+  // an idle flusher checks back every interval, before the first item is due
+  if (buffered == 1)
+    mFirstBuffered = chrono::steady_clock::now();
+
+  if (buffered == mFlushItems) {
+    mFlushCond.notify_one();
+  } else if (buffered >= MAX_BUFFER_FACTOR * mFlushItems) {
+    // the flusher is behind (or failing), push back on the producer
+    FlushLocked();
+  }
+}
+
+std::pair<bool, std::string> BufferedPersistentList::Front() const {
+  string value;
+  bool found = Front(&value);
+  return make_pair(found, value);
+}
+
+std::pair<bool, std::string> BufferedPersistentList::Back() const {
+  string value;
+  bool found = Back(&value);
+  return make_pair(found, value);
+}
+
+bool BufferedPersistentList::Front(std::string *value) const {
+  lock_guard<mutex> lock(mMutex);
+
+  if (!mFront.Empty()) {
+    value->assign(mFront.At(0));
+    return true;
+  }
+  if (!mListEmpty && mList->Front(value))
+    return true;
+  mListEmpty = true;
+  if (!mBack.Empty()) {
+    value->assign(mBack.At(0));
+    return true;
+  }
+  return false;
+}
+
+bool BufferedPersistentList::Back(std::string *value) const {
+  lock_guard<mutex> lock(mMutex);
+
+  if (!mBack.Empty()) {
+    value->assign(mBack.At(mBack.Size() - 1));
+    return true;
+  }
+  if (!mListEmpty && mList->Back(value))
+    return true;
+  mListEmpty = true;
+  if (!mFront.Empty()) {
+    value->assign(mFront.At(mFront.Size() - 1));
+    return true;
+  }
+  return false;
+}
+
+bool BufferedPersistentList::PopFront(std::string *value) {
+  lock_guard<mutex> lock(mMutex);
+
+  // an item pushed at the front goes without touching the database
+  if (!mFront.Empty()) {
+    if (value)
+      value->swap(mFront.At(0));
+    mFront.PopFront();
+    return true;
+  }
+  if (!mListEmpty &&
+      (value ? mList->Front(value) && mList->PopFront() : mList->PopFront()))
+    return true;
+  mListEmpty = true;
+  if (!mBack.Empty()) {
+    if (value)
+      value->swap(mBack.At(0));
+    mBack.PopFront();
+    return true;
+  }
+  return false;
+}
+
+bool BufferedPersistentList::PopBack(std::string *value) {
+  lock_guard<mutex> lock(mMutex);
+
+  if (!mBack.Empty()) {
+    if (value)
+      value->swap(mBack.At(mBack.Size() - 1));
+    mBack.PopBack();
+    return true;
+  }
+  if (!mListEmpty &&
+      (value ? mList->Back(value) && mList->PopBack() : mList->PopBack()))
+    return true;
+  mListEmpty = true;
+  if (!mFront.Empty()) {
+    if (value)
+      value->swap(mFront.At(mFront.Size() - 1));
+    mFront.PopBack();
+    return true;
+  }
+  return false;
+}
+
+void BufferedPersistentList::Clear() {
+  lock_guard<mutex> lock(mMutex);
+  mFront.Clear();
+  mBack.Clear();
+  mList->Clear();
+  mListEmpty = true;
+}
+
+bool BufferedPersistentList::Flush() {
+  lock_guard<mutex> lock(mMutex);
+  return FlushLocked();
+}
+
+// Needs mMutex. The front items get the keys before the first item of the
+// list, the back items the keys after the last one, as the pushes would.
+bool BufferedPersistentList::FlushLocked() {
+  if (mFront.Empty() && mBack.Empty())
+    return true;
+
+  PersistentList &list = *mList;
+  const size_t keyLen = list.mKeyPrefix.length() + PersistentList::KEY_LEN;
+  string firstKey, lastKey;
+  {
+    auto iter = unique_ptr<leveldb::Iterator>(mDB->NewIterator(mReadOptions));
+    iter->Seek(list.mHeadKey);
+    iter->Next();
+
+    if (iter->key() == list.mTailKey) {
+      firstKey.assign(list.mKeyPrefix).append(PersistentList::INIT_KEY_SEQ);
+      lastKey = firstKey;
+    } else {
+      firstKey.assign(iter->key().data(), keyLen);
+      iter->Seek(list.mTailKey);
+      iter->Prev();
+      lastKey.assign(iter->key().data(), keyLen);
+    }
+  }
+
+  leveldb::WriteBatch batch;
+  for (size_t i = mFront.Size(); i-- > 0;) {
+    list.PrevKeySeq(&firstKey[list.mKeyPrefix.length()]);
+    batch.Put(firstKey, mFront.At(i));
+  }
+  for (size_t i = 0; i < mBack.Size(); i++) {
+    list.NextKeySeq(&lastKey[list.mKeyPrefix.length()]);
+    batch.Put(lastKey, mBack.At(i));
+  }
+
+  if (!mDB->Write(mWriteOptions, &batch).ok()) {
+    // keep the items, the flusher retries after an interval
+    mFirstBuffered = chrono::steady_clock::now();
+    return false;
+  }
+
+  mListEmpty = false;
+  mFront.Clear();
+  mBack.Clear();
+  list.NotifyPush();
+  return true;
+}
+
+void BufferedPersistentList::FlushLoop() {
+  unique_lock<mutex> lock(mMutex);
+
+  while (!mStopping) {
+    size_t buffered = mFront.Size() + mBack.Size();
+    auto due = mFirstBuffered + mFlushInterval;
+
+    if (buffered == 0)
+      mFlushCond.wait_for(lock, mFlushInterval);
+    else if (buffered < mFlushItems && chrono::steady_clock::now() < due)
+      mFlushCond.wait_until(lock, due);
+    else
+      FlushLocked();
+  }
+}
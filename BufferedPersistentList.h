@@ -0,0 +1,128 @@
+#include <leveldb/db.h>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#pragma once
+
+class PersistentList;
+
+// Write-behind mode of a list: pushes land in an in-memory ring at each
+// end, and a background flusher writes them to the list in one
+// WriteBatch once flushItems are buffered or the oldest buffered item is
+// flushIntervalMs old. A crash loses at most that much.
+//
+// Pops and reads take the rings into account, so an item pushed and
+// popped before a flush never reaches the database. Other handles on the
+// list see the buffered items only after a flush; the buffered list
+// should be the only writer of its list.
+class BufferedPersistentList {
+public:
+  static std::shared_ptr<BufferedPersistentList>
+  Get(std::shared_ptr<leveldb::DB> db, const std::string &listName,
+      int flushItems = 1024, int flushIntervalMs = 100);
+
+  // Flushes what is still buffered
+  virtual ~BufferedPersistentList();
+
+  std::string Name() const;
+
+  // The persisted part of the list
+  inline std::shared_ptr<PersistentList> List() const { return mList; }
+
+  int Size() const;
+
+  // Items not written to the database yet
+  int Buffered() const;
+
+  // Keys are assigned when the items are flushed
+  void PushFront(const leveldb::Slice &value);
+  void PushBack(const leveldb::Slice &value);
+
+  std::pair<bool, std::string> Front() const;
+  std::pair<bool, std::string> Back() const;
+
+  bool Front(std::string *value) const;
+  bool Back(std::string *value) const;
+
+  bool PopFront(std::string *value = nullptr);
+  bool PopBack(std::string *value = nullptr);
+
+  void Clear();
+
+  // Barrier: the items pushed before the call are in the database when
+  // it returns true
+  bool Flush();
+
+private:
+  BufferedPersistentList(std::shared_ptr<leveldb::DB> db,
+                         const std::string &listName, int flushItems,
+                         int flushIntervalMs);
+
+  BufferedPersistentList(const BufferedPersistentList &list) = delete;
+  BufferedPersistentList &
+  operator=(const BufferedPersistentList &list) = delete;
+
+  // Double ended ring of values; popped slots keep their buffers
+  class Ring {
+  public:
+    inline bool Empty() const { return mCount == 0; }
+    inline size_t Size() const { return mCount; }
+
+    // i-th value from the front
+    inline std::string &At(size_t i) {
+      return mSlots[(mHead + i) & (mSlots.size() - 1)];
+    }
+    inline const std::string &At(size_t i) const {
+      return mSlots[(mHead + i) & (mSlots.size() - 1)];
+    }
+
+    // Return the new slot to fill
+    std::string &PushFront();
+    std::string &PushBack();
+
+    void PopFront();
+    void PopBack();
+
+    inline void Clear() { mCount = 0; }
+
+  private:
+    void Grow();
+
+    std::vector<std::string> mSlots;
+    size_t mHead = 0;
+    size_t mCount = 0;
+  };
+
+  void Pushed();
+  bool FlushLocked();
+  void FlushLoop();
+
+private:
+  // a push flushes by itself beyond this many times flushItems
+  static constexpr int MAX_BUFFER_FACTOR = 4;
+
+  std::shared_ptr<leveldb::DB> mDB;
+  std::shared_ptr<PersistentList> mList;
+  const size_t mFlushItems;
+  const std::chrono::milliseconds mFlushInterval;
+
+  // guards the rings and the list
+  mutable std::mutex mMutex;
+  std::condition_variable mFlushCond;
+  Ring mFront; // pushed at the front, newest first
+  Ring mBack;  // pushed at the back, oldest first
+  // the list was seen empty since the last flush: the rings meet
+  mutable bool mListEmpty;
+  std::chrono::steady_clock::time_point mFirstBuffered;
+  bool mStopping;
+  std::thread mFlusher;
+
+  leveldb::WriteOptions mWriteOptions;
+  leveldb::ReadOptions mReadOptions;
+};
@@ -0,0 +1,144 @@
+#include "DelayQueue.h"
+#include "PersistentList.h"
+#include "leveldb/write_batch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+
+using namespace std;
+
+constexpr uint64_t DelayQueue::NO_DUE_TIME;
+
+std::shared_ptr<DelayQueue> DelayQueue::Get(std::shared_ptr<leveldb::DB> db,
+                                            const std::string &listName) {
+  return std::shared_ptr<DelayQueue>(new DelayQueue(db, listName));
+}
+
+DelayQueue::DelayQueue(std::shared_ptr<leveldb::DB> db,
+                       const std::string &listName)
+    : mDB(db), mList(PersistentList::Get(db, listName)) {
+  // KEY_BASE ^ KEY_LEN - 1, the largest due time a key sequence can hold
+  long long range = 1;
+  for (int i = 0; i < PersistentList::KEY_LEN; i++)
+    range *= PersistentList::KEY_BASE;
+  mMaxDueTime = range - 1;
+  mState = GetQueueState();
+}
+
+std::shared_ptr<DelayQueue::QueueState> DelayQueue::GetQueueState() const {
+  typedef pair<const leveldb::DB *, string> StateKey;
+  static mutex registryMutex;
+  static map<StateKey, weak_ptr<QueueState>> registry;
+
+  lock_guard<mutex> lock(registryMutex);
+  auto &entry = registry[StateKey(mDB.get(), mList->Id())];
+  auto state = entry.lock();
+
+  if (!state) {
+    state = make_shared<QueueState>();
+    state->tiebreakSeq = LastTiebreakSeq();
+    mList->NextKeySeq(&state->tiebreakSeq[0]);
+    entry = state;
+  }
+  return state;
+}
+
+std::string DelayQueue::LastTiebreakSeq() const {
+  const size_t prefixLen = mList->mKeyPrefix.length();
+  const size_t keyLen = prefixLen + 2 * PersistentList::KEY_LEN;
+  string last(PersistentList::INIT_KEY_SEQ);
+  leveldb::Slice tailKey(mList->mTailKey);
+
+  auto iter =
+      unique_ptr<leveldb::Iterator>(mDB->NewIterator(mList->mReadOptions));
+  iter->Seek(mList->mHeadKey);
+  for (iter->Next(); iter->key() != tailKey; iter->Next()) {
+    leveldb::Slice key = iter->key();
+    if (key.size() < keyLen)
+      continue;
+    leveldb::Slice seq(key.data() + prefixLen + PersistentList::KEY_LEN,
+                       PersistentList::KEY_LEN);
+    if (seq.compare(last) > 0)
+      last.assign(seq.data(), seq.size());
+  }
+  return last;
+}
+
+DelayQueue::~DelayQueue() {}
+
+int DelayQueue::Size() const { return mList->Size(); }
+
+uint64_t DelayQueue::Now() {
+  return chrono::duration_cast<chrono::milliseconds>(
+             chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+std::string DelayQueue::GetDueKey(uint64_t dueTime) const {
+  string key = mList->mKeyPrefix;
+  key.resize(key.length() + PersistentList::KEY_LEN);
+  mList->NumberToKeySeq(min(dueTime, mMaxDueTime),
+                        &key[mList->mKeyPrefix.length()]);
+  return key;
+}
+
+uint64_t DelayQueue::DueTime(const std::string &itemKey) const {
+  size_t prefixLen = mList->mKeyPrefix.length();
+  return mList->KeySeqToNumber(itemKey.data() + prefixLen,
+                               itemKey.length() - prefixLen);
+}
+
+std::string DelayQueue::Push(const std::string &value, uint64_t dueTime) {
+  string key = GetDueKey(dueTime);
+
+  lock_guard<mutex> lock(mState->mutex);
+  key.append(mState->tiebreakSeq);
+  mList->NextKeySeq(&mState->tiebreakSeq[0]);
+  mDB->Put(mList->mWriteOptions, key, value);
+  mList->NotifyPush();
+  return key;
+}
+
+std::vector<std::string> DelayQueue::PopDue(uint64_t now, int max,
+                                            uint64_t *nextDueTime) {
+  // every key due at or before now sorts below the key of now + 1
+  string limitKey = GetDueKey(now == NO_DUE_TIME ? now : now + 1);
+  leveldb::Slice limit(limitKey);
+  leveldb::Slice tailKey(mList->mTailKey);
+  vector<string> values;
+  leveldb::WriteBatch batch;
+
+  lock_guard<mutex> lock(mState->mutex);
+  auto iter =
+      unique_ptr<leveldb::Iterator>(mDB->NewIterator(mList->mReadOptions));
+  iter->Seek(mList->mHeadKey);
+  iter->Next();
+
+  for (; (int)values.size() < max && iter->key().compare(limit) < 0 &&
+         iter->key() != tailKey;
+       iter->Next()) {
+    values.push_back(iter->value().ToString());
+    batch.Delete(iter->key());
+  }
+
+  if (!values.empty())
+    mDB->Write(mList->mWriteOptions, &batch);
+
+  if (nextDueTime != nullptr) {
+    *nextDueTime = iter->key() != tailKey ? DueTime(iter->key().ToString())
+                                           : NO_DUE_TIME;
+  }
+  return values;
+}
+
+uint64_t DelayQueue::NextDueTime() const {
+  auto iter =
+      unique_ptr<leveldb::Iterator>(mDB->NewIterator(mList->mReadOptions));
+  iter->Seek(mList->mHeadKey);
+  iter->Next();
+
+  if (iter->key() == leveldb::Slice(mList->mTailKey))
+    return NO_DUE_TIME;
+  return DueTime(iter->key().ToString());
+}
@@ -0,0 +1,75 @@
+#include <leveldb/db.h>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#pragma once
+
+class PersistentList;
+
+// A list ordered by due time. An item key sequence is the due time
+// followed by a tiebreak sequence, both KEY_LEN symbols of the list key
+// scheme, so the due items are always a prefix of the list.
+//
+// The items have to be pushed through this class; the list can be read and
+// iterated as any other list.
+class DelayQueue {
+public:
+  static constexpr uint64_t NO_DUE_TIME = UINT64_MAX;
+
+  static std::shared_ptr<DelayQueue> Get(std::shared_ptr<leveldb::DB> db,
+                                         const std::string &listName);
+
+  virtual ~DelayQueue();
+
+  inline std::shared_ptr<PersistentList> List() const { return mList; }
+
+  int Size() const;
+
+  // Milliseconds since the epoch, the time base of the due times
+  static uint64_t Now();
+
+  std::string Push(const std::string &value, uint64_t dueTime);
+
+  // Pops up to max items due at or before now, earliest first. The due
+  // time of the first remaining item (or NO_DUE_TIME) is returned through
+  // nextDueTime, for the caller to sleep until then.
+  std::vector<std::string> PopDue(uint64_t now, int max,
+                                  uint64_t *nextDueTime = nullptr);
+
+  uint64_t NextDueTime() const;
+
+  uint64_t DueTime(const std::string &itemKey) const;
+
+private:
+  DelayQueue(std::shared_ptr<leveldb::DB> db, const std::string &listName);
+
+  DelayQueue(const DelayQueue &queue) = delete;
+  DelayQueue &operator=(const DelayQueue &queue) = delete;
+
+  std::string GetDueKey(uint64_t dueTime) const;
+
+  // Shared by all instances of the same queue over the same database, so
+  // that they do not build the same key nor pop the same item.
+  struct QueueState {
+    // serializes the pushes and pops
+    std::mutex mutex;
+    // Tiebreak for equal due times, seeded past the largest one stored so
+    // it keeps growing across reopens and never rebuilds a queued key.
+    std::string tiebreakSeq;
+  };
+
+  std::shared_ptr<QueueState> GetQueueState() const;
+
+  // The largest tiebreak sequence of the queued items (a scan of the
+  // queue, once per process while an instance is open)
+  std::string LastTiebreakSeq() const;
+
+private:
+  std::shared_ptr<leveldb::DB> mDB;
+  std::shared_ptr<PersistentList> mList;
+  std::shared_ptr<QueueState> mState;
+  uint64_t mMaxDueTime;
+};
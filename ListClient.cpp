@@ -0,0 +1,303 @@
+#include "ListClient.h"
+#include "ListCoding.h"
+#include "ListProtocol.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace ListProtocol;
+
+std::shared_ptr<ListClient> ListClient::Connect(const std::string &socketPath) {
+  sockaddr_un addr = sockaddr_un();
+  addr.sun_family = AF_UNIX;
+  if (socketPath.length() >= sizeof(addr.sun_path))
+    return nullptr;
+  socketPath.copy(addr.sun_path, socketPath.length());
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+    return nullptr;
+
+  if (connect(fd, (sockaddr *)&addr, sizeof(addr)) != 0) {
+    close(fd);
+    return nullptr;
+  }
+  return shared_ptr<ListClient>(new ListClient(fd));
+}
+
+ListClient::ListClient(int fd)
+    : mFd(fd), mConnected(true), mInPos(0), mAsync(0) {}
+
+ListClient::~ListClient() { close(mFd); }
+
+bool ListClient::Connected() const { return mConnected; }
+
+void ListClient::Send(const std::string &request) {
+  PutFixed(&mOut, request.size(), 4);
+  mOut.append(request);
+}
+
+bool ListClient::Flush() {
+  size_t sent = 0;
+  while (mConnected && sent < mOut.size()) {
+    ssize_t n = send(mFd, mOut.data() + sent, mOut.size() - sent, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      mConnected = false;
+    else
+      sent += n;
+  }
+  mOut.clear();
+  return mConnected;
+}
+
+bool ListClient::Receive(std::string *response) {
+  char buffer[64 << 10];
+
+  while (mConnected) {
+    size_t available = mIn.size() - mInPos;
+    if (available >= 4) {
+      uint32_t length = GetFixed(mIn.data() + mInPos, 4);
+      if (length > MAX_FRAME_SIZE) {
+        mConnected = false;
+        break;
+      }
+      if (available - 4 >= length) {
+        response->assign(mIn, mInPos + 4, length);
+        mInPos += 4 + length;
+        if (mInPos == mIn.size()) {
+          mIn.clear();
+          mInPos = 0;
+        }
+        return !response->empty();
+      }
+    }
+
+    ssize_t n = recv(mFd, buffer, sizeof(buffer), 0);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      mConnected = false;
+    else
+      mIn.append(buffer, n);
+  }
+  return false;
+}
+
+bool ListClient::Call(const std::string &request, std::string *response) {
+  if (mAsync > 0)
+    Sync();
+
+  Send(request);
+  return Flush() && Receive(response);
+}
+
+void ListClient::SendAsync(const std::string &request) {
+  Send(request);
+  mAsync++;
+}
+
+int ListClient::Sync() {
+  int succeeded = 0;
+  string response;
+
+  Flush();
+  for (; mAsync > 0; mAsync--) {
+    if (Receive(&response) && response[0] == OK)
+      succeeded++;
+  }
+  return succeeded;
+}
+
+std::shared_ptr<RemotePersistentList>
+RemotePersistentList::Get(std::shared_ptr<ListClient> client,
+                          const std::string &listName) {
+  return shared_ptr<RemotePersistentList>(
+      new RemotePersistentList(client, listName));
+}
+
+RemotePersistentList::RemotePersistentList(std::shared_ptr<ListClient> client,
+                                           const std::string &listName)
+    : mClient(client), mListName(listName) {}
+
+std::string RemotePersistentList::Name() const { return mListName; }
+
+std::string RemotePersistentList::Request(uint8_t op) const {
+  string request(1, (char)op);
+  PutLengthPrefixed(&request, mListName);
+  return request;
+}
+
+bool RemotePersistentList::Call(const std::string &request,
+                                std::string *response) {
+  return mClient->Call(request, response) && (*response)[0] == OK;
+}
+
+int RemotePersistentList::Size() {
+  string response;
+  uint32_t size = 0;
+
+  if (Call(Request(SIZE), &response)) {
+    const char *p = response.data() + 1;
+    GetVarint32(&p, response.data() + response.size(), &size);
+  }
+  return size;
+}
+
+std::string RemotePersistentList::PushFront(const leveldb::Slice &value) {
+  string request = Request(PUSH_FRONT), response;
+  leveldb::Slice key;
+
+  PutLengthPrefixed(&request, value);
+  if (Call(request, &response)) {
+    const char *p = response.data() + 1;
+    GetLengthPrefixed(&p, response.data() + response.size(), &key);
+  }
+  return key.ToString();
+}
+
+std::string RemotePersistentList::PushBack(const leveldb::Slice &value) {
+  string request = Request(PUSH_BACK), response;
+  leveldb::Slice key;
+
+  PutLengthPrefixed(&request, value);
+  if (Call(request, &response)) {
+    const char *p = response.data() + 1;
+    GetLengthPrefixed(&p, response.data() + response.size(), &key);
+  }
+  return key.ToString();
+}
+
+std::vector<std::string>
+RemotePersistentList::PushBack(const std::vector<std::string> &values) {
+  string request = Request(PUSH_BACK_BATCH), response;
+  vector<string> keys;
+
+  PutVarint32(&request, values.size());
+  for (auto &value : values)
+    PutLengthPrefixed(&request, value);
+
+  if (Call(request, &response)) {
+    const char *p = response.data() + 1;
+    const char *limit = response.data() + response.size();
+    uint32_t count = 0;
+    leveldb::Slice key;
+
+    GetVarint32(&p, limit, &count);
+    for (uint32_t i = 0; i < count && GetLengthPrefixed(&p, limit, &key); i++)
+      keys.push_back(key.ToString());
+  }
+  return keys;
+}
+
+void RemotePersistentList::PushBackAsync(const leveldb::Slice &value) {
+  string request = Request(PUSH_BACK);
+  PutLengthPrefixed(&request, value);
+  mClient->SendAsync(request);
+}
+
+int RemotePersistentList::Sync() { return mClient->Sync(); }
+
+std::pair<bool, std::string> RemotePersistentList::Front() {
+  string value;
+  bool found = Pop(FRONT, &value);
+  return make_pair(found, value);
+}
+
+std::pair<bool, std::string> RemotePersistentList::Back() {
+  string value;
+  bool found = Pop(BACK, &value);
+  return make_pair(found, value);
+}
+
+bool RemotePersistentList::PopFront(std::string *value) {
+  return Pop(POP_FRONT, value);
+}
+
+bool RemotePersistentList::PopBack(std::string *value) {
+  return Pop(POP_BACK, value);
+}
+
+bool RemotePersistentList::Pop(uint8_t op, std::string *value,
+                               const std::string &request) {
+  string response;
+  leveldb::Slice result;
+
+  if (!Call(request.empty() ? Request(op) : request, &response))
+    return false;
+
+  const char *p = response.data() + 1;
+  if (!GetLengthPrefixed(&p, response.data() + response.size(), &result))
+    return false;
+  if (value)
+    value->assign(result.data(), result.size());
+  return true;
+}
+
+std::vector<std::string> RemotePersistentList::PopFront(int max) {
+  string request = Request(POP_FRONT_BATCH), response;
+  vector<string> values;
+
+  PutVarint32(&request, max);
+  if (Call(request, &response)) {
+    const char *p = response.data() + 1;
+    const char *limit = response.data() + response.size();
+    uint32_t count = 0;
+    leveldb::Slice value;
+
+    GetVarint32(&p, limit, &count);
+    for (uint32_t i = 0; i < count && GetLengthPrefixed(&p, limit, &value); i++)
+      values.push_back(value.ToString());
+  }
+  return values;
+}
+
+std::pair<bool, std::string> RemotePersistentList::WaitPopFront(int timeoutMs) {
+  string request = Request(POP_FRONT_WAIT), value;
+
+  PutVarint32(&request, timeoutMs);
+  bool found = Pop(POP_FRONT_WAIT, &value, request);
+  return make_pair(found, value);
+}
+
+bool RemotePersistentList::PopKey(const std::string &key) {
+  string request = Request(POP_KEY), response;
+  PutLengthPrefixed(&request, key);
+  return Call(request, &response);
+}
+
+bool RemotePersistentList::PopValue(const std::string &value) {
+  string request = Request(POP_VALUE), response;
+  PutLengthPrefixed(&request, value);
+  return Call(request, &response);
+}
+
+void RemotePersistentList::Clear() {
+  string response;
+  Call(Request(CLEAR), &response);
+}
+
+std::vector<std::pair<std::string, std::string>>
+RemotePersistentList::Scan(const std::string &afterKey, int max) {
+  string request = Request(SCAN), response;
+  vector<pair<string, string>> items;
+
+  PutLengthPrefixed(&request, afterKey);
+  PutVarint32(&request, max);
+  if (Call(request, &response)) {
+    const char *p = response.data() + 1;
+    const char *limit = response.data() + response.size();
+    uint32_t count = 0;
+    leveldb::Slice key, value;
+
+    GetVarint32(&p, limit, &count);
+    for (uint32_t i = 0; i < count && GetLengthPrefixed(&p, limit, &key) &&
+                         GetLengthPrefixed(&p, limit, &value);
+         i++)
+      items.emplace_back(key.ToString(), value.ToString());
+  }
+  return items;
+}
@@ -0,0 +1,108 @@
+#include <leveldb/slice.h>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#pragma once
+
+// A connection to a ListServer. Requests are queued and sent on Flush, so
+// many of them can be in flight before their responses are read.
+class ListClient {
+public:
+  static std::shared_ptr<ListClient> Connect(const std::string &socketPath);
+
+  virtual ~ListClient();
+
+  // Queues a request payload
+  void Send(const std::string &request);
+
+  // Sends the queued requests
+  bool Flush();
+
+  // Reads the next response payload
+  bool Receive(std::string *response);
+
+  // Sends a request and reads its response, after the async ones
+  bool Call(const std::string &request, std::string *response);
+
+  // Queues a request whose response is only counted by Sync()
+  void SendAsync(const std::string &request);
+
+  // Waits for the async requests, returns how many of them succeeded
+  int Sync();
+
+  bool Connected() const;
+
+private:
+  explicit ListClient(int fd);
+
+  ListClient(const ListClient &) = delete;
+  ListClient &operator=(const ListClient &) = delete;
+
+private:
+  int mFd;
+  bool mConnected;
+  std::string mOut;
+  std::string mIn;
+  size_t mInPos;
+  int mAsync;
+};
+
+// The PersistentList API on a list served by a ListServer. Pops return
+// the popped values, since another client may change the list between
+// a Front() and a PopFront().
+class RemotePersistentList {
+public:
+  static std::shared_ptr<RemotePersistentList>
+  Get(std::shared_ptr<ListClient> client, const std::string &listName);
+
+  std::string Name() const;
+
+  int Size();
+
+  std::string PushFront(const leveldb::Slice &value);
+  std::string PushBack(const leveldb::Slice &value);
+
+  // Pushes all the values in one request, returns their keys
+  std::vector<std::string> PushBack(const std::vector<std::string> &values);
+
+  // Pipelined push, the result is collected by Sync()
+  void PushBackAsync(const leveldb::Slice &value);
+  int Sync();
+
+  std::pair<bool, std::string> Front();
+  std::pair<bool, std::string> Back();
+
+  bool PopFront(std::string *value = nullptr);
+  bool PopBack(std::string *value = nullptr);
+
+  // Pops up to max values from the front in one request
+  std::vector<std::string> PopFront(int max);
+
+  // Pops the front value, waiting up to the timeout (at most
+  // ListProtocol::MAX_WAIT_MS) for one to be pushed
+  std::pair<bool, std::string> WaitPopFront(int timeoutMs);
+
+  bool PopKey(const std::string &key);
+  bool PopValue(const std::string &value);
+
+  void Clear();
+
+  // Up to max (key, value) pairs after the given key, from the front if
+  // the key is empty
+  std::vector<std::pair<std::string, std::string>>
+  Scan(const std::string &afterKey, int max);
+
+private:
+  RemotePersistentList(std::shared_ptr<ListClient> client,
+                       const std::string &listName);
+
+  std::string Request(uint8_t op) const;
+  bool Call(const std::string &request, std::string *response);
+  bool Pop(uint8_t op, std::string *value, const std::string &request = "");
+
+private:
+  std::shared_ptr<ListClient> mClient;
+  std::string mListName;
+};
@@ -0,0 +1,101 @@
+#include <leveldb/slice.h>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#pragma once
+
+// Codecs map list values to their stored bytes at compile time. A codec
+// is a type with
+//
+//   static leveldb::Slice Encode(const T &value, std::string *buffer);
+//   static bool Decode(const leveldb::Slice &data, T *value);
+//
+// Encode may point the returned slice into buffer (reused by the caller
+// across calls) or straight into the value. A protobuf message codec, for
+// example, would use SerializeToString(buffer) and ParseFromArray().
+
+template <typename T, typename Enable = void> struct ListCodec;
+
+// Trivially copyable types are stored as their bytes (host byte order).
+// The padding bytes of a struct are stored too, with whatever they hold,
+// so equal values may be stored differently. Pointers would not point
+// anywhere once read back and are refused.
+template <typename T>
+struct ListCodec<
+    T, typename std::enable_if<std::is_trivially_copyable<T>::value>::type> {
+  static_assert(!std::is_pointer<T>::value,
+                "ListCodec can not store pointers");
+
+  static leveldb::Slice Encode(const T &value, std::string * /*buffer*/) {
+    return leveldb::Slice(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  static bool Decode(const leveldb::Slice &data, T *value) {
+    if (data.size() != sizeof(T))
+      return false;
+    memcpy(value, data.data(), sizeof(T));
+    return true;
+  }
+};
+
+template <> struct ListCodec<std::string> {
+  static leveldb::Slice Encode(const std::string &value,
+                               std::string * /*buffer*/) {
+    return leveldb::Slice(value);
+  }
+
+  static bool Decode(const leveldb::Slice &data, std::string *value) {
+    value->assign(data.data(), data.size());
+    return true;
+  }
+};
+
+// Integers as varints, zigzag encoded when signed: small values take
+// fewer bytes than their fixed width.
+template <typename T> struct VarintCodec {
+  static_assert(std::is_integral<T>::value, "VarintCodec needs an integer");
+
+  typedef typename std::make_unsigned<T>::type UnsignedT;
+
+  static leveldb::Slice Encode(const T &value, std::string *buffer) {
+    UnsignedT bits = ZigZag(value, std::is_signed<T>());
+    char data[sizeof(T) * 8 / 7 + 1];
+    int len = 0;
+
+    while (bits >= 0x80) {
+      data[len++] = (char)(bits | 0x80);
+      bits >>= 7;
+    }
+    data[len++] = (char)bits;
+    buffer->assign(data, len);
+    return leveldb::Slice(*buffer);
+  }
+
+  static bool Decode(const leveldb::Slice &data, T *value) {
+    UnsignedT bits = 0;
+    for (size_t i = 0; i < data.size(); i++) {
+      if (i * 7 >= sizeof(T) * 8)
+        return false;
+      UnsignedT byte = (uint8_t)data[i];
+      bits |= (byte & 0x7F) << (i * 7);
+      if ((byte & 0x80) == 0) {
+        *value = UnZigZag(bits, std::is_signed<T>());
+        return i + 1 == data.size();
+      }
+    }
+    return false;
+  }
+
+private:
+  static UnsignedT ZigZag(T value, std::true_type) {
+    return ((UnsignedT)value << 1) ^ (UnsignedT)(value >> (sizeof(T) * 8 - 1));
+  }
+  static UnsignedT ZigZag(T value, std::false_type) { return value; }
+
+  static T UnZigZag(UnsignedT bits, std::true_type) {
+    return (T)((bits >> 1) ^ (~(bits & 1) + 1));
+  }
+  static T UnZigZag(UnsignedT bits, std::false_type) { return bits; }
+};
@@ -0,0 +1,54 @@
+#include <leveldb/slice.h>
+#include <cstdint>
+#include <string>
+
+#pragma once
+
+// Byte encodings shared by the export files and the list server protocol:
+// little endian fixed ints, varints and length prefixed slices.
+
+inline void PutFixed(std::string *dst, uint64_t value, int bytes) {
+  for (int i = 0; i < bytes; i++)
+    dst->push_back((char)((value >> (8 * i)) & 0xFF));
+}
+
+inline uint64_t GetFixed(const char *src, int bytes) {
+  uint64_t value = 0;
+  for (int i = 0; i < bytes; i++)
+    value |= (uint64_t)(uint8_t)src[i] << (8 * i);
+  return value;
+}
+
+inline void PutVarint32(std::string *dst, uint32_t value) {
+  while (value >= 0x80) {
+    dst->push_back((char)(value | 0x80));
+    value >>= 7;
+  }
+  dst->push_back((char)value);
+}
+
+inline bool GetVarint32(const char **p, const char *limit, uint32_t *value) {
+  *value = 0;
+  for (int shift = 0; shift <= 28 && *p < limit; shift += 7) {
+    uint32_t byte = (uint8_t) * (*p)++;
+    *value |= (byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0)
+      return true;
+  }
+  return false;
+}
+
+inline void PutLengthPrefixed(std::string *dst, const leveldb::Slice &s) {
+  PutVarint32(dst, s.size());
+  dst->append(s.data(), s.size());
+}
+
+inline bool GetLengthPrefixed(const char **p, const char *limit,
+                              leveldb::Slice *s) {
+  uint32_t len;
+  if (!GetVarint32(p, limit, &len) || len > (uint32_t)(limit - *p))
+    return false;
+  *s = leveldb::Slice(*p, len);
+  *p += len;
+  return true;
+}
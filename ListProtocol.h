@@ -0,0 +1,52 @@
+#include <cstdint>
+
+#pragma once
+
+// Binary protocol of the list server over a Unix domain socket.
+//
+// Every message is a frame: fixed32 payload length | payload.
+//
+// Request payload:  u8 op | lp list name | op arguments
+// Response payload: u8 status | op results
+//
+// where lp is a varint32 length prefixed string and n a varint32. A
+// connection answers its requests in order, so a client may pipeline
+// many requests before reading the responses.
+//
+// Only the pushes (and POP_FRONT_WAIT, for the pushes it waits for)
+// create a list; the other ops answer for a missing list as for an empty
+// one.
+namespace ListProtocol {
+
+enum Op : uint8_t {
+  SIZE = 1,            // -> n size
+  PUSH_FRONT = 2,      // lp value -> lp key
+  PUSH_BACK = 3,       // lp value -> lp key
+  PUSH_BACK_BATCH = 4, // n count, count * lp value -> n count, count * lp key
+                       // (one write: all the values or none)
+  FRONT = 5,           // -> lp value
+  BACK = 6,            // -> lp value
+  POP_FRONT = 7,       // -> lp value
+  POP_BACK = 8,        // -> lp value
+  POP_FRONT_BATCH = 9, // n max -> n count, count * lp value
+  POP_FRONT_WAIT = 10, // n timeout ms (at most MAX_WAIT_MS) -> lp value
+  POP_KEY = 11,        // lp key ->
+  POP_VALUE = 12,      // lp value ->
+  CLEAR = 13,          // ->
+  SCAN = 14,           // lp after key, n max -> n count, count * (lp key, lp value)
+};
+
+enum Status : uint8_t {
+  OK = 0,
+  NOT_FOUND = 1, // empty list, no such item, timeout
+  BAD_REQUEST = 2,
+  WRITE_FAILED = 3, // the database refused a write
+};
+
+constexpr uint32_t MAX_FRAME_SIZE = 64 << 20;
+
+// longer POP_FRONT_WAIT timeouts are cut to this, the wait holds up the
+// connection's later requests
+constexpr uint32_t MAX_WAIT_MS = 60 * 1000;
+
+} // namespace ListProtocol
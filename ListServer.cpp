@@ -0,0 +1,405 @@
+#include "ListServer.h"
+#include "ListCoding.h"
+#include "ListProtocol.h"
+#include "PersistentList.h"
+#include "PersistentListIterator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace ListProtocol;
+
+namespace {
+
+bool IsCreatingOp(uint8_t op) {
+  return op == PUSH_FRONT || op == PUSH_BACK || op == PUSH_BACK_BATCH ||
+         op == POP_FRONT_WAIT;
+}
+
+// Answers an op on a list that does not exist as on an empty list;
+// false for a bad request
+bool ExecuteOnMissingList(uint8_t op, const char *p, const char *limit,
+                          std::string *out, size_t status) {
+  leveldb::Slice arg;
+  uint32_t num = 0;
+
+  switch (op) {
+  case SIZE:
+    PutVarint32(out, 0);
+    return true;
+
+  case FRONT:
+  case BACK:
+  case POP_FRONT:
+  case POP_BACK:
+    (*out)[status] = NOT_FOUND;
+    return true;
+
+  case POP_FRONT_BATCH:
+    if (!GetVarint32(&p, limit, &num))
+      return false;
+    PutVarint32(out, 0);
+    return true;
+
+  case POP_KEY:
+  case POP_VALUE:
+    if (!GetLengthPrefixed(&p, limit, &arg))
+      return false;
+    (*out)[status] = NOT_FOUND;
+    return true;
+
+  case CLEAR:
+    return true;
+
+  case SCAN:
+    if (!GetLengthPrefixed(&p, limit, &arg) || !GetVarint32(&p, limit, &num))
+      return false;
+    PutVarint32(out, 0);
+    return true;
+
+  default:
+    return false;
+  }
+}
+
+} // namespace
+
+constexpr int ListServer::WAIT_SLICE_MS;
+
+ListServer::ListServer(std::shared_ptr<leveldb::DB> db,
+                       const std::string &socketPath)
+    : mDB(db), mSocketPath(socketPath), mListenFd(-1), mStopping(false) {}
+
+ListServer::~ListServer() { Stop(); }
+
+bool ListServer::Start() {
+  sockaddr_un addr = sockaddr_un();
+  addr.sun_family = AF_UNIX;
+  if (mSocketPath.length() >= sizeof(addr.sun_path))
+    return false;
+  mSocketPath.copy(addr.sun_path, mSocketPath.length());
+
+  mListenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (mListenFd < 0)
+    return false;
+
+  unlink(mSocketPath.c_str());
+  if (bind(mListenFd, (sockaddr *)&addr, sizeof(addr)) != 0 ||
+      listen(mListenFd, SOMAXCONN) != 0) {
+    close(mListenFd);
+    mListenFd = -1;
+    return false;
+  }
+
+  mStopping = false;
+  mAcceptThread = thread(&ListServer::AcceptLoop, this);
+  return true;
+}
+
+void ListServer::Stop() {
+  if (mListenFd < 0)
+    return;
+
+  mStopping = true;
+  shutdown(mListenFd, SHUT_RDWR);
+  mAcceptThread.join();
+  close(mListenFd);
+  mListenFd = -1;
+  unlink(mSocketPath.c_str());
+
+  unique_lock<mutex> lock(mConnMutex);
+  for (auto &conn : mConnections)
+    shutdown(conn.first, SHUT_RDWR);
+  mConnDone.wait(lock, [this] { return mConnections.empty(); });
+}
+
+void ListServer::AcceptLoop() {
+  while (!mStopping) {
+    int fd = accept(mListenFd, nullptr, nullptr);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+      break;
+    }
+
+    lock_guard<mutex> lock(mConnMutex);
+    if (mStopping) {
+      close(fd);
+      break;
+    }
+    mConnections[fd] = true;
+    thread(&ListServer::Serve, this, fd).detach();
+  }
+}
+
+ListServer::ListEntry *ListServer::GetList(const std::string &listName,
+                                           bool create) {
+  lock_guard<mutex> lock(mListsMutex);
+  auto found = mLists.find(listName);
+  if (found != mLists.end())
+    return found->second.get();
+
+  auto list = create ? PersistentList::Get(mDB, listName)
+                     : PersistentList::GetExisting(mDB, listName);
+  if (!list)
+    return nullptr;
+
+  auto &entry = mLists[listName];
+  entry.reset(new ListEntry);
+  entry->list = list;
+  return entry.get();
+}
+
+bool ListServer::SendAll(int fd, const std::string &data) {
+  size_t sent = 0;
+  while (sent < data.size()) {
+    ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    sent += n;
+  }
+  return true;
+}
+
+void ListServer::Serve(int fd) {
+  string in, out;
+  vector<char> buffer(64 << 10);
+  bool open = true;
+
+  while (open && !mStopping) {
+    ssize_t n = recv(fd, buffer.data(), buffer.size(), 0);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      break;
+    in.append(buffer.data(), n);
+
+    // run all the complete (pipelined) requests, answer them in one go
+    size_t pos = 0;
+    while (in.size() - pos >= 4) {
+      uint32_t length = GetFixed(in.data() + pos, 4);
+      if (length > MAX_FRAME_SIZE) {
+        open = false;
+        break;
+      }
+      if (in.size() - pos - 4 < length)
+        break;
+
+      Execute(leveldb::Slice(in.data() + pos + 4, length), fd, &out);
+      pos += 4 + length;
+    }
+    in.erase(0, pos);
+
+    if (!out.empty()) {
+      open = open && SendAll(fd, out);
+      out.clear();
+    }
+  }
+
+  // closed only once Stop() can not shut it down any more: the fd number
+  // may be reused right after the close
+  lock_guard<mutex> lock(mConnMutex);
+  mConnections.erase(fd);
+  close(fd);
+  mConnDone.notify_all();
+}
+
+void ListServer::Execute(const leveldb::Slice &request, int fd,
+                         std::string *out) {
+  const char *p = request.data();
+  const char *limit = p + request.size();
+
+  // response frame: the length is filled in at the end
+  size_t frameStart = out->size();
+  PutFixed(out, 0, 4);
+  out->push_back(OK);
+  size_t status = frameStart + 4;
+
+  leveldb::Slice listName, arg;
+  uint32_t num = 0;
+  bool valid = p < limit;
+  uint8_t op = valid ? (uint8_t)*p++ : 0;
+  valid = valid && op >= SIZE && op <= SCAN &&
+          GetLengthPrefixed(&p, limit, &listName);
+
+  // a list is created only by the ops that add to it
+  ListEntry *entry = nullptr;
+  if (valid) {
+    entry = GetList(listName.ToString(), IsCreatingOp(op));
+    if (entry == nullptr)
+      valid = ExecuteOnMissingList(op, p, limit, out, status);
+  }
+
+  if (valid && entry != nullptr) {
+    PersistentList &list = *entry->list;
+    unique_lock<mutex> lock(entry->mutex);
+    string value;
+
+    switch (op) {
+    case SIZE:
+      PutVarint32(out, list.Size());
+      break;
+
+    case PUSH_FRONT:
+    case PUSH_BACK:
+      valid = GetLengthPrefixed(&p, limit, &arg);
+      if (valid) {
+        PutLengthPrefixed(out, op == PUSH_FRONT ? list.PushFront(arg)
+                                                : list.PushBack(arg));
+      }
+      break;
+
+    case PUSH_BACK_BATCH: {
+      // all or nothing: parsed in full before the one write batch
+      vector<leveldb::Slice> values;
+      valid = GetVarint32(&p, limit, &num) && num <= request.size();
+      for (uint32_t i = 0; valid && i < num; i++) {
+        valid = GetLengthPrefixed(&p, limit, &arg);
+        values.push_back(arg);
+      }
+      if (!valid)
+        break;
+
+      auto keys = list.PushBack(values);
+      if (keys.size() != values.size()) {
+        (*out)[status] = WRITE_FAILED;
+        break;
+      }
+      PutVarint32(out, keys.size());
+      for (auto &key : keys)
+        PutLengthPrefixed(out, key);
+      break;
+    }
+
+    case FRONT:
+    case BACK:
+    case POP_FRONT:
+    case POP_BACK:
+      if (op == FRONT || op == POP_FRONT ? list.Front(&value)
+                                         : list.Back(&value)) {
+        if (op == POP_FRONT)
+          list.PopFront();
+        else if (op == POP_BACK)
+          list.PopBack();
+        PutLengthPrefixed(out, value);
+      } else {
+        (*out)[status] = NOT_FOUND;
+      }
+      break;
+
+    case POP_FRONT_BATCH: {
+      valid = GetVarint32(&p, limit, &num);
+      string values;
+      uint32_t count = 0;
+      for (; valid && count < num && list.Front(&value); count++) {
+        list.PopFront();
+        PutLengthPrefixed(&values, value);
+      }
+      PutVarint32(out, count);
+      out->append(values);
+      break;
+    }
+
+    case POP_FRONT_WAIT: {
+      valid = GetVarint32(&p, limit, &num);
+      if (!valid)
+        break;
+
+      auto deadline = chrono::steady_clock::now() +
+                      chrono::milliseconds(min(num, MAX_WAIT_MS));
+      bool found = false;
+
+      // the earlier responses should not wait behind this one
+      lock.unlock();
+      string pending(*out, 0, frameStart);
+      out->erase(0, frameStart);
+      frameStart = 0;
+      status = 4;
+      SendAll(fd, pending);
+
+      while (true) {
+        lock.lock();
+        uint64_t version = list.PushVersion();
+        found = list.Front(&value);
+        if (found)
+          list.PopFront();
+        lock.unlock();
+
+        int remaining = (int)chrono::duration_cast<chrono::milliseconds>(
+                            deadline - chrono::steady_clock::now())
+                            .count();
+        if (found || remaining <= 0 || mStopping)
+          break;
+        list.WaitForPush(version, min(remaining, WAIT_SLICE_MS));
+      }
+
+      if (found)
+        PutLengthPrefixed(out, value);
+      else
+        (*out)[status] = NOT_FOUND;
+      break;
+    }
+
+    case POP_KEY:
+    case POP_VALUE:
+      valid = GetLengthPrefixed(&p, limit, &arg) &&
+              (op == POP_VALUE || list.IsItemKey(arg));
+      if (valid && !(op == POP_KEY ? list.PopKey(arg.ToString())
+                                   : list.PopValue(arg.ToString())))
+        (*out)[status] = NOT_FOUND;
+      break;
+
+    case CLEAR:
+      list.Clear();
+      break;
+
+    case SCAN: {
+      // the key has to be one of this list, not another list's
+      valid = GetLengthPrefixed(&p, limit, &arg) &&
+              GetVarint32(&p, limit, &num) &&
+              (arg.empty() || list.IsItemKey(arg));
+      if (!valid)
+        break;
+
+      PersistentListIterator iter(entry->list);
+      bool more;
+      if (arg.empty()) {
+        iter.SeekFront();
+        more = iter.Next();
+      } else {
+        more = iter.Seek(arg.ToString());
+        if (more && iter.KeySlice() == arg)
+          more = iter.Next();
+      }
+
+      string items;
+      uint32_t count = 0;
+      for (; more && count < num; count++, more = iter.Next()) {
+        PutLengthPrefixed(&items, iter.KeySlice());
+        PutLengthPrefixed(&items, iter.ValueSlice());
+      }
+      PutVarint32(out, count);
+      out->append(items);
+      break;
+    }
+
+    default:
+      valid = false;
+    }
+  }
+
+  if (!valid) {
+    out->resize(frameStart + 4);
+    out->push_back(BAD_REQUEST);
+  }
+
+  uint32_t length = out->size() - frameStart - 4;
+  for (int i = 0; i < 4; i++)
+    (*out)[frameStart + i] = (char)((length >> (8 * i)) & 0xFF);
+}
@@ -0,0 +1,67 @@
+#include <leveldb/db.h>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#pragma once
+
+class PersistentList;
+
+// Serves the lists of a database to other processes over a Unix domain
+// socket (see ListProtocol.h), one thread per connection. The operations
+// on a list are serialized by a lock per list.
+class ListServer {
+public:
+  ListServer(std::shared_ptr<leveldb::DB> db, const std::string &socketPath);
+
+  virtual ~ListServer();
+
+  // Binds the socket and starts accepting connections
+  bool Start();
+
+  // Closes the socket and all connections, waiting for their threads
+  void Stop();
+
+private:
+  ListServer(const ListServer &) = delete;
+  ListServer &operator=(const ListServer &) = delete;
+
+  struct ListEntry {
+    std::shared_ptr<PersistentList> list;
+    std::mutex mutex;
+  };
+
+  // nullptr for a list that does not exist, unless create
+  ListEntry *GetList(const std::string &listName, bool create);
+
+  void AcceptLoop();
+  void Serve(int fd);
+
+  // Executes a request and appends the response frame to out. Blocking
+  // requests first send what is in out.
+  void Execute(const leveldb::Slice &request, int fd, std::string *out);
+
+  static bool SendAll(int fd, const std::string &data);
+
+private:
+  // longest wait of a blocking pop before checking for a stop
+  static constexpr int WAIT_SLICE_MS = 100;
+
+  std::shared_ptr<leveldb::DB> mDB;
+  std::string mSocketPath;
+  int mListenFd;
+  std::atomic<bool> mStopping;
+  std::thread mAcceptThread;
+
+  std::mutex mListsMutex;
+  std::map<std::string, std::unique_ptr<ListEntry>> mLists;
+
+  // open connections, their threads are detached
+  std::mutex mConnMutex;
+  std::condition_variable mConnDone;
+  std::map<int, bool> mConnections;
+};
@@ -0,0 +1,49 @@
+#include "ListServer.h"
+#include "MemoryDB.h"
+#include <csignal>
+#include <iostream>
+#include <pthread.h>
+
+using namespace std;
+
+// Usage: listserver <db path> <socket path>
+// The db path :memory: serves lists of an in-memory store.
+int main(int argc, char **argv) {
+  if (argc != 3) {
+    cerr << "usage: " << argv[0] << " <db path> <socket path>" << endl;
+    return 1;
+  }
+
+  shared_ptr<leveldb::DB> db;
+  if (string(argv[1]) == ":memory:") {
+    db = MemoryDB::Open();
+  } else {
+    leveldb::DB *ldb;
+    leveldb::Options options;
+    options.create_if_missing = true;
+    leveldb::Status status = leveldb::DB::Open(options, argv[1], &ldb);
+    if (!status.ok()) {
+      cerr << status.ToString() << endl;
+      return 1;
+    }
+    db.reset(ldb);
+  }
+
+  // the server threads inherit the mask, the signals are taken below
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+  ListServer server(db, argv[2]);
+  if (!server.Start()) {
+    cerr << "cannot listen on " << argv[2] << endl;
+    return 1;
+  }
+
+  int signal;
+  sigwait(&signals, &signal);
+  server.Stop();
+  return 0;
+}
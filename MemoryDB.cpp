@@ -0,0 +1,479 @@
+#include "MemoryDB.h"
+#include <leveldb/write_batch.h>
+
+#include <algorithm>
+#include <cassert>
+#include <new>
+
+using namespace std;
+
+constexpr int MemoryDB::MAX_HEIGHT;
+constexpr size_t MemoryDB::ARENA_BLOCK_SIZE;
+
+// recycled values keep their buffer up to this size
+static const size_t MAX_KEPT_CAPACITY = 4 << 10;
+
+class MemoryDB::MemorySnapshot : public leveldb::Snapshot {
+public:
+  explicit MemorySnapshot(uint64_t seq) : seq(seq) {}
+  ~MemorySnapshot() override {}
+
+  const uint64_t seq;
+};
+
+class MemoryDB::BatchHandler : public leveldb::WriteBatch::Handler {
+public:
+  BatchHandler(MemoryDB *db, uint64_t seq) : mDB(db), mSeq(seq) {}
+
+  void Put(const leveldb::Slice &key, const leveldb::Slice &value) override {
+    mDB->Apply(key, &value, mSeq);
+  }
+  void Delete(const leveldb::Slice &key) override {
+    mDB->Apply(key, nullptr, mSeq);
+  }
+
+private:
+  MemoryDB *mDB;
+  uint64_t mSeq;
+};
+
+// Reads as of its sequence; it is a reader of the database until deleted,
+// so the node and version it is positioned on stay valid.
+class MemoryDB::MemoryIterator : public leveldb::Iterator {
+public:
+  MemoryIterator(MemoryDB *db, uint64_t seq)
+      : mDB(db), mSeq(seq), mNode(nullptr), mVersion(nullptr) {}
+
+  ~MemoryIterator() override {
+    lock_guard<mutex> lock(mDB->mMutex);
+    mDB->RemoveReader(mSeq);
+  }
+
+  bool Valid() const override { return mNode != nullptr; }
+
+  void SeekToFirst() override {
+    lock_guard<mutex> lock(mDB->mMutex);
+    SkipForward(mDB->mHead->next[0]);
+  }
+
+  void SeekToLast() override {
+    lock_guard<mutex> lock(mDB->mMutex);
+    SkipBackward(mDB->FindLast());
+  }
+
+  void Seek(const leveldb::Slice &target) override {
+    lock_guard<mutex> lock(mDB->mMutex);
+    SkipForward(mDB->FindGreaterOrEqual(target, nullptr));
+  }
+
+  void Next() override {
+    assert(Valid());
+    lock_guard<mutex> lock(mDB->mMutex);
+    SkipForward(mNode->next[0]);
+  }
+
+  void Prev() override {
+    assert(Valid());
+    lock_guard<mutex> lock(mDB->mMutex);
+    SkipBackward(mDB->FindLessThan(mNode->key));
+  }
+
+  leveldb::Slice key() const override { return mNode->key; }
+  leveldb::Slice value() const override { return mVersion->value; }
+  leveldb::Status status() const override { return leveldb::Status::OK(); }
+
+private:
+  void SkipForward(Node *node) {
+    while (node && !(mVersion = Visible(node, mSeq)))
+      node = node->next[0];
+    mNode = node;
+  }
+
+  void SkipBackward(Node *node) {
+    while (node && !(mVersion = Visible(node, mSeq)))
+      node = mDB->FindLessThan(node->key);
+    mNode = node;
+  }
+
+private:
+  MemoryDB *mDB;
+  uint64_t mSeq;
+  Node *mNode;
+  const Version *mVersion;
+};
+
+std::shared_ptr<leveldb::DB> MemoryDB::Open() {
+  return shared_ptr<leveldb::DB>(new MemoryDB());
+}
+
+MemoryDB::MemoryDB()
+    : mHeight(1), mRandom(0xdeadbeef), mLastSeq(0), mEntries(0),
+      mGarbageLimit(64), mAllocPtr(nullptr), mAllocRemaining(0),
+      mArenaUsage(0), mFreeVersions(nullptr) {
+  fill(mFreeNodes, mFreeNodes + MAX_HEIGHT, nullptr);
+  mHead = NewNode(leveldb::Slice(), MAX_HEIGHT);
+}
+
+MemoryDB::~MemoryDB() {
+  assert(mReaders.empty());
+
+  for (Node *node = mHead; node;) {
+    Node *next = node->next[0];
+    FreeNode(node);
+    node = next;
+  }
+  // everything is on the free lists now, the arena blocks go with them
+  for (Node *node : mFreeNodes) {
+    while (node) {
+      Node *next = node->next[0];
+      node->~Node();
+      node = next;
+    }
+  }
+  while (mFreeVersions) {
+    Version *older = mFreeVersions->older;
+    mFreeVersions->~Version();
+    mFreeVersions = older;
+  }
+}
+
+char *MemoryDB::Allocate(size_t bytes) {
+  bytes = (bytes + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1);
+
+  if (bytes > mAllocRemaining) {
+    size_t blockSize = max(bytes, ARENA_BLOCK_SIZE);
+    mBlocks.emplace_back(new char[blockSize]);
+    mAllocPtr = mBlocks.back().get();
+    mAllocRemaining = blockSize;
+    mArenaUsage += blockSize;
+  }
+
+  char *result = mAllocPtr;
+  mAllocPtr += bytes;
+  mAllocRemaining -= bytes;
+  return result;
+}
+
+MemoryDB::Node *MemoryDB::NewNode(const leveldb::Slice &key, int height) {
+  Node *node = mFreeNodes[height - 1];
+
+  if (node) {
+    mFreeNodes[height - 1] = node->next[0];
+  } else {
+    node = new (Allocate(sizeof(Node) + sizeof(Node *) * (height - 1))) Node();
+    node->height = height;
+  }
+
+  node->key.assign(key.data(), key.size());
+  node->versions = nullptr;
+  node->garbage = false;
+  fill(node->next, node->next + height, nullptr);
+  return node;
+}
+
+void MemoryDB::FreeNode(Node *node) {
+  while (node->versions) {
+    Version *older = node->versions->older;
+    FreeVersion(node->versions);
+    node->versions = older;
+  }
+
+  node->key.clear();
+  node->next[0] = mFreeNodes[node->height - 1];
+  mFreeNodes[node->height - 1] = node;
+}
+
+MemoryDB::Version *MemoryDB::NewVersion() {
+  Version *version = mFreeVersions;
+
+  if (version)
+    mFreeVersions = version->older;
+  else
+    version = new (Allocate(sizeof(Version))) Version();
+  return version;
+}
+
+void MemoryDB::FreeVersion(Version *version) {
+  if (version->value.capacity() > MAX_KEPT_CAPACITY)
+    string().swap(version->value);
+  else
+    version->value.clear();
+
+  version->older = mFreeVersions;
+  mFreeVersions = version;
+}
+
+int MemoryDB::RandomHeight() {
+  // xorshift32, a level up with probability 1/4
+  int height = 1;
+  while (height < MAX_HEIGHT) {
+    mRandom ^= mRandom << 13;
+    mRandom ^= mRandom >> 17;
+    mRandom ^= mRandom << 5;
+    if (mRandom % 4 != 0)
+      break;
+    height++;
+  }
+  return height;
+}
+
+MemoryDB::Node *MemoryDB::FindGreaterOrEqual(const leveldb::Slice &key,
+                                             Node **prev) const {
+  Node *node = mHead;
+  int level = mHeight - 1;
+
+  while (true) {
+    Node *next = node->next[level];
+    if (next && leveldb::Slice(next->key).compare(key) < 0) {
+      node = next;
+    } else {
+      if (prev)
+        prev[level] = node;
+      if (level == 0)
+        return next;
+      level--;
+    }
+  }
+}
+
+MemoryDB::Node *MemoryDB::FindLessThan(const leveldb::Slice &key) const {
+  Node *node = mHead;
+
+  for (int level = mHeight - 1; level >= 0; level--) {
+    while (node->next[level] &&
+           leveldb::Slice(node->next[level]->key).compare(key) < 0)
+      node = node->next[level];
+  }
+  return node == mHead ? nullptr : node;
+}
+
+MemoryDB::Node *MemoryDB::FindLast() const {
+  Node *node = mHead;
+
+  for (int level = mHeight - 1; level >= 0; level--) {
+    while (node->next[level])
+      node = node->next[level];
+  }
+  return node == mHead ? nullptr : node;
+}
+
+const MemoryDB::Version *MemoryDB::Visible(const Node *node, uint64_t seq) {
+  const Version *version = node->versions;
+
+  while (version && version->seq > seq)
+    version = version->older;
+  return version && !version->deleted ? version : nullptr;
+}
+
+void MemoryDB::Apply(const leveldb::Slice &key, const leveldb::Slice *value,
+                     uint64_t seq) {
+  Node *prev[MAX_HEIGHT];
+  Node *node = FindGreaterOrEqual(key, prev);
+
+  if (!node || leveldb::Slice(node->key) != key) {
+    if (!value)
+      return;
+
+    int height = RandomHeight();
+    for (; mHeight < height; mHeight++)
+      prev[mHeight] = mHead;
+
+    node = NewNode(key, height);
+    for (int i = 0; i < height; i++) {
+      node->next[i] = prev[i]->next[i];
+      prev[i]->next[i] = node;
+    }
+    mEntries++;
+  } else if (!value && node->versions->deleted) {
+    return;
+  }
+
+  // a key written twice in one batch keeps the last write
+  Version *version = node->versions;
+  if (!version || version->seq != seq) {
+    version = NewVersion();
+    version->seq = seq;
+    version->older = node->versions;
+    node->versions = version;
+  }
+
+  version->deleted = !value;
+  if (value)
+    version->value.assign(value->data(), value->size());
+  else
+    version->value.clear();
+
+  if (!version->older && !version->deleted)
+    return;
+
+  if (mReaders.empty()) {
+    if (Prune(node))
+      Unlink(node);
+  } else if (!node->garbage) {
+    node->garbage = true;
+    mGarbage.push_back(node);
+    if (mGarbage.size() >= mGarbageLimit)
+      CollectGarbage();
+  }
+}
+
+bool MemoryDB::Prune(Node *node) {
+  Version *newest = node->versions;
+  uint64_t newerSeq = newest->seq;
+  Version **link = &newest->older;
+
+  // an older version is seen by the readers in [its seq, the newer seq)
+  while (*link) {
+    Version *version = *link;
+    uint64_t seq = version->seq;
+    auto reader = mReaders.lower_bound(seq);
+
+    if (reader != mReaders.end() && *reader < newerSeq) {
+      link = &version->older;
+    } else {
+      *link = version->older;
+      FreeVersion(version);
+    }
+    newerSeq = seq;
+  }
+  return newest->deleted && !newest->older;
+}
+
+void MemoryDB::Unlink(Node *node) {
+  Node *prev[MAX_HEIGHT];
+  FindGreaterOrEqual(node->key, prev);
+
+  for (int i = 0; i < node->height; i++)
+    prev[i]->next[i] = node->next[i];
+  FreeNode(node);
+  mEntries--;
+}
+
+void MemoryDB::CollectGarbage() {
+  vector<Node *> pending;
+  pending.swap(mGarbage);
+
+  for (Node *node : pending) {
+    node->garbage = false;
+    if (Prune(node)) {
+      Unlink(node);
+    } else if (node->versions->older || node->versions->deleted) {
+      node->garbage = true;
+      mGarbage.push_back(node);
+    }
+  }
+  mGarbageLimit = max<size_t>(64, 2 * mGarbage.size());
+}
+
+uint64_t MemoryDB::AddReader(uint64_t seq) {
+  mReaders.insert(seq);
+  return seq;
+}
+
+void MemoryDB::RemoveReader(uint64_t seq) {
+  auto reader = mReaders.find(seq);
+  assert(reader != mReaders.end());
+  bool oldest = reader == mReaders.begin();
+  mReaders.erase(reader);
+
+  // the versions are needed as long as the oldest reader lives, mostly
+  if (!mGarbage.empty() &&
+      (mReaders.empty() || (oldest && *mReaders.begin() != seq) ||
+       mGarbage.size() >= mGarbageLimit))
+    CollectGarbage();
+}
+
+leveldb::Status MemoryDB::Put(const leveldb::WriteOptions & /*options*/,
+                              const leveldb::Slice &key,
+                              const leveldb::Slice &value) {
+  lock_guard<mutex> lock(mMutex);
+  Apply(key, &value, ++mLastSeq);
+  return leveldb::Status::OK();
+}
+
+leveldb::Status MemoryDB::Delete(const leveldb::WriteOptions & /*options*/,
+                                 const leveldb::Slice &key) {
+  lock_guard<mutex> lock(mMutex);
+  Apply(key, nullptr, ++mLastSeq);
+  return leveldb::Status::OK();
+}
+
+leveldb::Status MemoryDB::Write(const leveldb::WriteOptions & /*options*/,
+                                leveldb::WriteBatch *updates) {
+  lock_guard<mutex> lock(mMutex);
+  BatchHandler handler(this, ++mLastSeq);
+  return updates->Iterate(&handler);
+}
+
+leveldb::Status MemoryDB::Get(const leveldb::ReadOptions &options,
+                              const leveldb::Slice &key, std::string *value) {
+  lock_guard<mutex> lock(mMutex);
+  uint64_t seq = options.snapshot
+                     ? static_cast<const MemorySnapshot *>(options.snapshot)->seq
+                     : mLastSeq;
+  Node *node = FindGreaterOrEqual(key, nullptr);
+  const Version *version = nullptr;
+
+  if (node && leveldb::Slice(node->key) == key)
+    version = Visible(node, seq);
+  if (!version)
+    return leveldb::Status::NotFound(key);
+
+  value->assign(version->value);
+  return leveldb::Status::OK();
+}
+
+leveldb::Iterator *MemoryDB::NewIterator(const leveldb::ReadOptions &options) {
+  lock_guard<mutex> lock(mMutex);
+  uint64_t seq = options.snapshot
+                     ? static_cast<const MemorySnapshot *>(options.snapshot)->seq
+                     : mLastSeq;
+  return new MemoryIterator(this, AddReader(seq));
+}
+
+const leveldb::Snapshot *MemoryDB::GetSnapshot() {
+  lock_guard<mutex> lock(mMutex);
+  return new MemorySnapshot(AddReader(mLastSeq));
+}
+
+void MemoryDB::ReleaseSnapshot(const leveldb::Snapshot *snapshot) {
+  auto memorySnapshot = static_cast<const MemorySnapshot *>(snapshot);
+  {
+    lock_guard<mutex> lock(mMutex);
+    RemoveReader(memorySnapshot->seq);
+  }
+  delete memorySnapshot;
+}
+
+bool MemoryDB::GetProperty(const leveldb::Slice &property, std::string *value) {
+  lock_guard<mutex> lock(mMutex);
+
+  if (property == "memorydb.num-entries")
+    *value = to_string(mEntries);
+  else if (property == "memorydb.arena-usage")
+    *value = to_string(mArenaUsage);
+  else
+    return false;
+  return true;
+}
+
+void MemoryDB::GetApproximateSizes(const leveldb::Range *range, int n,
+                                   uint64_t *sizes) {
+  lock_guard<mutex> lock(mMutex);
+
+  for (int i = 0; i < n; i++) {
+    sizes[i] = 0;
+    for (Node *node = FindGreaterOrEqual(range[i].start, nullptr);
+         node && leveldb::Slice(node->key).compare(range[i].limit) < 0;
+         node = node->next[0]) {
+      if (!node->versions->deleted)
+        sizes[i] += node->key.size() + node->versions->value.size();
+    }
+  }
+}
+
+void MemoryDB::CompactRange(const leveldb::Slice * /*begin*/,
+                            const leveldb::Slice * /*end*/) {
+  lock_guard<mutex> lock(mMutex);
+  CollectGarbage();
+}
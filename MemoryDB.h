@@ -0,0 +1,124 @@
+#include <leveldb/db.h>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#pragma once
+
+// An in-memory, ordered key-value engine behind the leveldb::DB interface,
+// for lists that do not need durability (scratch queues, tests). Any list
+// type takes it in place of a LevelDB database:
+//
+//   auto pl = PersistentList::Get(MemoryDB::Open(), "scratch");
+//
+// Items live in a skiplist whose nodes and versions come from an arena
+// and are recycled through free lists. Every write gets a sequence number
+// and adds a version to its node, so snapshots and iterators read as of
+// their sequence like LevelDB. Versions (and deleted nodes) no reader can
+// see any more are reclaimed as the readers go away.
+class MemoryDB : public leveldb::DB {
+public:
+  static std::shared_ptr<leveldb::DB> Open();
+
+  ~MemoryDB() override;
+
+  leveldb::Status Put(const leveldb::WriteOptions &options,
+                      const leveldb::Slice &key,
+                      const leveldb::Slice &value) override;
+  leveldb::Status Delete(const leveldb::WriteOptions &options,
+                         const leveldb::Slice &key) override;
+  leveldb::Status Write(const leveldb::WriteOptions &options,
+                        leveldb::WriteBatch *updates) override;
+  leveldb::Status Get(const leveldb::ReadOptions &options,
+                      const leveldb::Slice &key, std::string *value) override;
+  leveldb::Iterator *NewIterator(const leveldb::ReadOptions &options) override;
+  const leveldb::Snapshot *GetSnapshot() override;
+  void ReleaseSnapshot(const leveldb::Snapshot *snapshot) override;
+
+  // "memorydb.num-entries" and "memorydb.arena-usage"
+  bool GetProperty(const leveldb::Slice &property, std::string *value) override;
+
+  // Key and value bytes of the live items in the ranges
+  void GetApproximateSizes(const leveldb::Range *range, int n,
+                           uint64_t *sizes) override;
+
+  // Reclaims what the current readers do not need
+  void CompactRange(const leveldb::Slice *begin,
+                    const leveldb::Slice *end) override;
+
+private:
+  MemoryDB();
+
+  class MemoryIterator;
+  class MemorySnapshot;
+  class BatchHandler;
+
+  struct Version {
+    uint64_t seq;
+    bool deleted;
+    std::string value;
+    Version *older;
+  };
+
+  struct Node {
+    std::string key;
+    Version *versions; // newest first
+    bool garbage;      // in mGarbage
+    int height;
+    Node *next[1];
+  };
+
+  char *Allocate(size_t bytes);
+  Node *NewNode(const leveldb::Slice &key, int height);
+  void FreeNode(Node *node);
+  Version *NewVersion();
+  void FreeVersion(Version *version);
+  int RandomHeight();
+
+  // Fills prev (if given) with the last node before key at every level
+  Node *FindGreaterOrEqual(const leveldb::Slice &key, Node **prev) const;
+  Node *FindLessThan(const leveldb::Slice &key) const;
+  Node *FindLast() const;
+
+  static const Version *Visible(const Node *node, uint64_t seq);
+
+  // Adds a version of key at seq, a deletion if value is null
+  void Apply(const leveldb::Slice &key, const leveldb::Slice *value,
+             uint64_t seq);
+
+  // Drops the versions no reader can see, returns true if only a deletion
+  // remains (the node can go)
+  bool Prune(Node *node);
+  void Unlink(Node *node);
+  void CollectGarbage();
+
+  uint64_t AddReader(uint64_t seq);
+  void RemoveReader(uint64_t seq);
+
+private:
+  static constexpr int MAX_HEIGHT = 12;
+  static constexpr size_t ARENA_BLOCK_SIZE = 64 << 10;
+
+  std::mutex mMutex;
+  Node *mHead;
+  int mHeight;
+  uint32_t mRandom;
+  uint64_t mLastSeq;
+  size_t mEntries;
+
+  // sequences of the live snapshots and iterators
+  std::multiset<uint64_t> mReaders;
+
+  // nodes holding versions that live readers may still need
+  std::vector<Node *> mGarbage;
+  size_t mGarbageLimit;
+
+  std::vector<std::unique_ptr<char[]>> mBlocks;
+  char *mAllocPtr;
+  size_t mAllocRemaining;
+  size_t mArenaUsage;
+  Node *mFreeNodes[MAX_HEIGHT];
+  Version *mFreeVersions;
+};
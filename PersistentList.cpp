@@ -1,19 +1,68 @@
 #include "PersistentList.h"
+#include "ListCoding.h"
 #include "PersistentListIterator.h"
 #include "leveldb/db.h"
+#include "leveldb/write_batch.h"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
 #include <iostream>
+#include <map>
+#include <mutex>
 #include <string>
 #include <vector>
 
 using namespace std;
 
+namespace {
+
+// CRC-32 of the export file blocks
+uint32_t Crc32(const char *data, size_t n) {
+  static const vector<uint32_t> table = [] {
+    vector<uint32_t> t(256);
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; k++)
+        c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+      t[i] = c;
+    }
+    return t;
+  }();
+
+  uint32_t crc = 0xFFFFFFFF;
+  for (size_t i = 0; i < n; i++)
+    crc = table[(crc ^ (uint8_t)data[i]) & 0xFF] ^ (crc >> 8);
+  return crc ^ 0xFFFFFFFF;
+}
+
+} // namespace
+
+struct PersistentList::PushSignal {
+  std::atomic<uint64_t> version{0};
+  std::atomic<int> waiters{0};
+  std::mutex mutex;
+  std::condition_variable cond;
+};
+
 std::shared_ptr<PersistentList>
 PersistentList::Get(std::shared_ptr<leveldb::DB> db,
                     const std::string &listName) {
   return std::shared_ptr<PersistentList>(new PersistentList(db, listName));
 }
 
+std::shared_ptr<PersistentList>
+PersistentList::GetExisting(std::shared_ptr<leveldb::DB> db,
+                            const std::string &listName) {
+  string idValue;
+  if (!db->Get(leveldb::ReadOptions(), KEY_PREFIX + listName + "/id", &idValue)
+           .ok())
+    return nullptr;
+  return Get(db, listName);
+}
+
 PersistentList::PersistentList(std::shared_ptr<leveldb::DB> db,
                                const std::string &listName)
     : mDB(db), mListName(listName) {
@@ -49,93 +98,152 @@ PersistentList::PersistentList(std::shared_ptr<leveldb::DB> db,
   mKeyPrefix = KEY_PREFIX + mListId + "/";
   mHeadKey = GetKey(string(1, START_SYM));
   mTailKey = GetKey(string(1, END_SYM));
+  mPushSignal = GetPushSignal(mDB.get(), mListId);
 }
 
 std::string PersistentList::Name() const { return mListName; }
 
 int PersistentList::Size() const {
   auto iter = unique_ptr<leveldb::Iterator>(mDB->NewIterator(mReadOptions));
+  leveldb::Slice tailKey(mTailKey);
   iter->Seek(mHeadKey);
   int count = 0;
 
-  while (true) {
-    iter->Next();
-    string nextKey = iter->key().ToString();
-
-    if (mTailKey.compare(nextKey) == 0)
-      break;
-
+  for (iter->Next(); iter->key() != tailKey; iter->Next())
     count++;
-  }
+
   return count;
 }
 
-std::string PersistentList::PushFront(const std::string &value) {
+// The push/pop paths compare slices and build the new key in the caller's
+// buffer, so nothing is allocated beyond the database calls once the buffer
+// has grown to the key length. The iterator can not be reused: it would not
+// see the later writes.
+
+std::string PersistentList::PushFront(const leveldb::Slice &value) {
+  string key;
+  PushFront(value, &key);
+  return key;
+}
+
+std::string PersistentList::PushBack(const leveldb::Slice &value) {
+  string key;
+  PushBack(value, &key);
+  return key;
+}
+
+bool PersistentList::PushFront(const leveldb::Slice &value, std::string *key) {
   auto iter = unique_ptr<leveldb::Iterator>(mDB->NewIterator(mReadOptions));
   iter->Seek(mHeadKey);
   iter->Next();
-  string firstKey = iter->key().ToString();
-  string prevKey;
+  leveldb::Slice firstKey = iter->key();
 
-  if (mTailKey.compare(firstKey) == 0) {
-    prevKey = GetKey(INIT_KEY_SEQ);
+  if (firstKey == mTailKey) {
+    key->assign(mKeyPrefix).append(INIT_KEY_SEQ);
   } else {
-    prevKey = PrevKey(firstKey);
+    key->assign(firstKey.data(), mKeyPrefix.length() + KEY_LEN);
+    PrevKeySeq(&(*key)[mKeyPrefix.length()]);
   }
-  mDB->Put(mWriteOptions, prevKey, value);
-  return prevKey;
+  if (!mDB->Put(mWriteOptions, *key, value).ok())
+    return false;
+  NotifyPush();
+  return true;
 }
 
-std::string PersistentList::PushBack(const std::string &value) {
+bool PersistentList::PushBack(const leveldb::Slice &value, std::string *key) {
   auto iter = unique_ptr<leveldb::Iterator>(mDB->NewIterator(mReadOptions));
   iter->Seek(mTailKey);
   iter->Prev();
-  string lastKey = iter->key().ToString();
-  string nextKey;
+  leveldb::Slice lastKey = iter->key();
 
-  if (mHeadKey.compare(lastKey) == 0) {
-    nextKey = GetKey(INIT_KEY_SEQ);
+  if (lastKey == mHeadKey) {
+    key->assign(mKeyPrefix).append(INIT_KEY_SEQ);
   } else {
-    nextKey = NextKey(lastKey);
+    key->assign(lastKey.data(), mKeyPrefix.length() + KEY_LEN);
+    NextKeySeq(&(*key)[mKeyPrefix.length()]);
   }
-  mDB->Put(mWriteOptions, nextKey, value);
-  return nextKey;
+  if (!mDB->Put(mWriteOptions, *key, value).ok())
+    return false;
+  NotifyPush();
+  return true;
 }
 
-std::pair<bool, std::string> PersistentList::Front() const {
+std::vector<std::string>
+PersistentList::PushBack(const std::vector<leveldb::Slice> &values) {
+  vector<string> keys;
+  if (values.empty())
+    return keys;
+
   auto iter = unique_ptr<leveldb::Iterator>(mDB->NewIterator(mReadOptions));
-  iter->Seek(mHeadKey);
-  iter->Next();
-  string firstKey = iter->key().ToString();
+  iter->Seek(mTailKey);
+  iter->Prev();
+  leveldb::Slice lastKey = iter->key();
+  string key;
 
-  if (mTailKey.compare(firstKey) != 0) {
-    return pair<bool, string>(true, iter->value().ToString());
+  if (lastKey == mHeadKey) {
+    key.assign(mKeyPrefix).append(INIT_KEY_SEQ);
+    PrevKeySeq(&key[mKeyPrefix.length()]);
   } else {
-    return pair<bool, std::string>(false, "");
+    key.assign(lastKey.data(), mKeyPrefix.length() + KEY_LEN);
+  }
+
+  leveldb::WriteBatch batch;
+  keys.reserve(values.size());
+  for (auto &value : values) {
+    NextKeySeq(&key[mKeyPrefix.length()]);
+    batch.Put(key, value);
+    keys.push_back(key);
   }
+
+  if (!mDB->Write(mWriteOptions, &batch).ok())
+    return vector<string>();
+  NotifyPush();
+  return keys;
 }
 
-std::pair<bool, std::string> PersistentList::Back() const {
+bool PersistentList::Front(std::string *value) const {
+  auto iter = unique_ptr<leveldb::Iterator>(mDB->NewIterator(mReadOptions));
+  iter->Seek(mHeadKey);
+  iter->Next();
+
+  if (iter->key() == mTailKey)
+    return false;
+
+  value->assign(iter->value().data(), iter->value().size());
+  return true;
+}
+
+bool PersistentList::Back(std::string *value) const {
   auto iter = unique_ptr<leveldb::Iterator>(mDB->NewIterator(mReadOptions));
   iter->Seek(mTailKey);
   iter->Prev();
-  string lastKey = iter->key().ToString();
 
-  if (mHeadKey.compare(lastKey) != 0) {
-    return pair<bool, string>(true, iter->value().ToString());
-  } else {
-    return pair<bool, std::string>(false, "");
-  }
+  if (iter->key() == mHeadKey)
+    return false;
+
+  value->assign(iter->value().data(), iter->value().size());
+  return true;
+}
+
+std::pair<bool, std::string> PersistentList::Front() const {
+  pair<bool, string> front(false, string());
+  front.first = Front(&front.second);
+  return front;
+}
+
+std::pair<bool, std::string> PersistentList::Back() const {
+  pair<bool, string> back(false, string());
+  back.first = Back(&back.second);
+  return back;
 }
 
 bool PersistentList::PopFront() {
   auto iter = unique_ptr<leveldb::Iterator>(mDB->NewIterator(mReadOptions));
   iter->Seek(mHeadKey);
   iter->Next();
-  string firstKey = iter->key().ToString();
 
-  if (mTailKey.compare(firstKey) != 0) {
-    leveldb::Status s = mDB->Delete(mWriteOptions, firstKey);
+  if (iter->key() != mTailKey) {
+    leveldb::Status s = mDB->Delete(mWriteOptions, iter->key());
     return s.ok();
   } else {
     return false;
@@ -146,34 +254,37 @@ bool PersistentList::PopBack() {
   auto iter = unique_ptr<leveldb::Iterator>(mDB->NewIterator(mReadOptions));
   iter->Seek(mTailKey);
   iter->Prev();
-  string lastKey = iter->key().ToString();
 
-  if (mHeadKey.compare(lastKey) != 0) {
-    leveldb::Status s = mDB->Delete(mWriteOptions, lastKey);
+  if (iter->key() != mHeadKey) {
+    leveldb::Status s = mDB->Delete(mWriteOptions, iter->key());
     return s.ok();
   } else {
     return false;
   }
 }
 
+bool PersistentList::IsItemKey(const leveldb::Slice &key) const {
+  return key.starts_with(mKeyPrefix) && key.compare(mHeadKey) > 0 &&
+         key.compare(mTailKey) < 0;
+}
+
 bool PersistentList::PopKey(const std::string &key) {
+  if (!IsItemKey(key))
+    return false;
   leveldb::Status s = mDB->Delete(mWriteOptions, key);
   return s.ok();
 }
 
 bool PersistentList::PopValue(const std::string &value) {
   auto iter = unique_ptr<leveldb::Iterator>(mDB->NewIterator(mReadOptions));
+  leveldb::Slice tailKey(mTailKey);
+  leveldb::Slice valueSlice(value);
   iter->Seek(mHeadKey);
   bool deleted = false;
-  while (true) {
-    iter->Next();
-    string nextKey = iter->key().ToString();
 
-    if (mTailKey.compare(nextKey) == 0)
-      break;
-
-    if (value.compare(iter->value().ToString()) == 0) {
-      mDB->Delete(mWriteOptions, nextKey);
+  for (iter->Next(); iter->key() != tailKey; iter->Next()) {
+    if (iter->value() == valueSlice) {
+      mDB->Delete(mWriteOptions, iter->key());
       deleted = true;
     }
   }
@@ -182,17 +293,11 @@ bool PersistentList::PopValue(const std::string &value) {
 
 void PersistentList::Clear() {
   auto iter = unique_ptr<leveldb::Iterator>(mDB->NewIterator(mReadOptions));
+  leveldb::Slice tailKey(mTailKey);
   iter->Seek(mHeadKey);
-  bool deleted = false;
-  while (true) {
-    iter->Next();
-    string nextKey = iter->key().ToString();
-
-    if (mTailKey.compare(nextKey) == 0)
-      break;
 
-    mDB->Delete(mWriteOptions, nextKey);
-  }
+  for (iter->Next(); iter->key() != tailKey; iter->Next())
+    mDB->Delete(mWriteOptions, iter->key());
 }
 
 void PersistentList::Compact() {
@@ -201,8 +306,189 @@ void PersistentList::Compact() {
   mDB->CompactRange(&rangeStart, &rangeEnd);
 }
 
+// File layout:
+//   magic
+//   blocks:  fixed32 length | fixed32 crc | records
+//   trailer: fixed32 0 | fixed64 item count
+// where a record is a length prefixed key sequence and value.
+std::pair<bool, int>
+PersistentList::ExportTo(const std::string &path,
+                         const leveldb::Snapshot *snapshot) const {
+  ofstream out(path, ios::binary | ios::trunc);
+  if (!out)
+    return pair<bool, int>(false, 0);
+
+  leveldb::ReadOptions readOptions = mReadOptions;
+  readOptions.snapshot = snapshot;
+  readOptions.fill_cache = false;
+  auto iter = unique_ptr<leveldb::Iterator>(mDB->NewIterator(readOptions));
+
+  string block;
+  block.reserve(EXPORT_BLOCK_SIZE + 4096);
+  string header;
+  uint64_t count = 0;
+
+  auto flushBlock = [&]() {
+    header.clear();
+    PutFixed(&header, block.size(), 4);
+    PutFixed(&header, Crc32(block.data(), block.size()), 4);
+    out.write(header.data(), header.size());
+    out.write(block.data(), block.size());
+    block.clear();
+  };
+
+  out.write(EXPORT_MAGIC, 4);
+  leveldb::Slice tailKey(mTailKey);
+  iter->Seek(mHeadKey);
+
+  for (iter->Next(); iter->key() != tailKey; iter->Next()) {
+    leveldb::Slice key = iter->key();
+    leveldb::Slice value = iter->value();
+    key.remove_prefix(mKeyPrefix.length());
+
+    PutLengthPrefixed(&block, key);
+    PutLengthPrefixed(&block, value);
+    count++;
+
+    if (block.size() >= EXPORT_BLOCK_SIZE)
+      flushBlock();
+  }
+
+  if (!block.empty())
+    flushBlock();
+
+  header.clear();
+  PutFixed(&header, 0, 4);
+  PutFixed(&header, count, 8);
+  out.write(header.data(), header.size());
+  out.close();
+
+  return pair<bool, int>(!out.fail(), (int)count);
+}
+
+std::pair<bool, int> PersistentList::ImportFrom(const std::string &path,
+                                                bool preserveKeys) {
+  ifstream in(path, ios::binary);
+  char magic[4];
+  if (!in.read(magic, 4) || string(magic, 4) != EXPORT_MAGIC)
+    return pair<bool, int>(false, 0);
+
+  // the key run continues from the current back of the list
+  auto iter = unique_ptr<leveldb::Iterator>(mDB->NewIterator(mReadOptions));
+  iter->Seek(mTailKey);
+  iter->Prev();
+  string lastKey = iter->key().ToString();
+  string nextKey = mHeadKey.compare(lastKey) == 0 ? GetKey(INIT_KEY_SEQ)
+                                                  : NextKey(lastKey);
+  char *nextKeySeq = &nextKey[mKeyPrefix.length()];
+
+  leveldb::WriteBatch batch;
+  size_t batchBytes = 0;
+  string block;
+  string itemKey(mKeyPrefix);
+  int count = 0;
+
+  while (true) {
+    char header[8];
+    if (!in.read(header, 4))
+      break;
+
+    uint32_t length = GetFixed(header, 4);
+    if (length == 0) {
+      // trailer: all blocks are in
+      if (!in.read(header, 8) || GetFixed(header, 8) != (uint64_t)count)
+        break;
+      if (batchBytes > 0)
+        mDB->Write(mWriteOptions, &batch);
+      NotifyPush();
+      return pair<bool, int>(true, count);
+    }
+
+    block.resize(length);
+    if (!in.read(header + 4, 4) || !in.read(&block[0], length) ||
+        Crc32(block.data(), length) != GetFixed(header + 4, 4))
+      break;
+
+    const char *p = block.data();
+    const char *limit = p + length;
+    leveldb::Slice keySeq, value;
+
+    while (p < limit && GetLengthPrefixed(&p, limit, &keySeq) &&
+           GetLengthPrefixed(&p, limit, &value)) {
+      if (preserveKeys) {
+        itemKey.resize(mKeyPrefix.length());
+        itemKey.append(keySeq.data(), keySeq.size());
+        batch.Put(itemKey, value);
+      } else {
+        batch.Put(nextKey, value);
+        NextKeySeq(nextKeySeq);
+      }
+      batchBytes += nextKey.size() + value.size();
+      count++;
+
+      if (batchBytes >= IMPORT_BATCH_SIZE) {
+        mDB->Write(mWriteOptions, &batch);
+        batch.Clear();
+        batchBytes = 0;
+      }
+    }
+    if (p != limit)
+      break;
+  }
+
+  // corrupt or truncated file
+  if (batchBytes > 0)
+    mDB->Write(mWriteOptions, &batch);
+  NotifyPush();
+  return pair<bool, int>(false, count);
+}
+
+std::shared_ptr<PersistentList::PushSignal>
+PersistentList::GetPushSignal(const leveldb::DB *db,
+                              const std::string &listId) {
+  typedef pair<const leveldb::DB *, string> SignalKey;
+  static mutex registryMutex;
+  static map<SignalKey, weak_ptr<PushSignal>> registry;
+
+  lock_guard<mutex> lock(registryMutex);
+  auto &entry = registry[SignalKey(db, listId)];
+  auto signal = entry.lock();
+
+  if (!signal) {
+    signal = make_shared<PushSignal>();
+    entry = signal;
+  }
+  return signal;
+}
+
+uint64_t PersistentList::PushVersion() const { return mPushSignal->version; }
+
+bool PersistentList::WaitForPush(uint64_t version, int timeoutMs) const {
+  PushSignal &signal = *mPushSignal;
+  auto deadline =
+      chrono::steady_clock::now() + chrono::milliseconds(timeoutMs);
+
+  signal.waiters++;
+  unique_lock<mutex> lock(signal.mutex);
+  bool pushed = signal.cond.wait_until(
+      lock, deadline, [&signal, version] { return signal.version != version; });
+  signal.waiters--;
+  return pushed;
+}
+
+void PersistentList::NotifyPush() {
+  PushSignal &signal = *mPushSignal;
+  signal.version++;
+
+  // the waiters register before checking the version, so none is missed
+  if (signal.waiters > 0) {
+    lock_guard<mutex> lock(signal.mutex);
+    signal.cond.notify_all();
+  }
+}
+
 std::string PersistentList::InsertAt(const PersistentListIterator *iter,
-                                     const std::string &value) {
+                                     const leveldb::Slice &value) {
   using namespace std;
   assert(iter->Valid());
   assert(iter->ListId().compare(mListId) == 0);
@@ -218,20 +504,27 @@ std::string PersistentList::InsertAt(const PersistentListIterator *iter,
   }
   string middleKey = MidKey(prevKey, nextKey);
   mDB->Put(mWriteOptions, middleKey, value);
+  NotifyPush();
   return middleKey;
 }
 
 std::string PersistentList::NextKey(const std::string &key) const {
-  const char *keyData = string(key, mKeyPrefix.length()).c_str();
-  char nextKeyData[KEY_LEN];
+  string nextKey(key, 0, mKeyPrefix.length() + KEY_LEN);
+  NextKeySeq(&nextKey[mKeyPrefix.length()]);
+  return nextKey;
+}
 
-  for (int i = 0; i < KEY_LEN; i++)
-    nextKeyData[i] = keyData[i];
+std::string PersistentList::PrevKey(const std::string &key) const {
+  string prevKey(key, 0, mKeyPrefix.length() + KEY_LEN);
+  PrevKeySeq(&prevKey[mKeyPrefix.length()]);
+  return prevKey;
+}
 
+void PersistentList::NextKeySeq(char *keySeq) const {
   char carry = 0;
 
   for (int i = KEY_LEN - 1; i >= 0; i--) {
-    const char c = nextKeyData[i];
+    const char c = keySeq[i];
     char next_c = c + carry + (char)((i == KEY_LEN - 1) ? 1 : 0);
     carry = 0;
 
@@ -239,25 +532,18 @@ std::string PersistentList::NextKey(const std::string &key) const {
       next_c = START_SYM + 1;
       carry = 1;
     }
-    nextKeyData[i] = next_c;
+    keySeq[i] = next_c;
 
     if (carry == 0)
       break;
   }
-  return mKeyPrefix + string(nextKeyData, KEY_LEN);
 }
 
-std::string PersistentList::PrevKey(const std::string &key) const {
-  const char *keyData = string(key, mKeyPrefix.length()).c_str();
-  char nextKeyData[KEY_LEN];
-
-  for (int i = 0; i < KEY_LEN; i++)
-    nextKeyData[i] = keyData[i];
-
+void PersistentList::PrevKeySeq(char *keySeq) const {
   char carry = 0;
 
   for (int i = KEY_LEN - 1; i >= 0; i--) {
-    const char c = nextKeyData[i];
+    const char c = keySeq[i];
     char next_c = c - carry - (char)((i == KEY_LEN - 1) ? 1 : 0);
     carry = 0;
 
@@ -265,12 +551,11 @@ std::string PersistentList::PrevKey(const std::string &key) const {
       next_c = END_SYM - 1;
       carry = 1;
     }
-    nextKeyData[i] = next_c;
+    keySeq[i] = next_c;
 
     if (carry == 0)
       break;
   }
-  return mKeyPrefix + string(nextKeyData, KEY_LEN);
 }
 
 std::string PersistentList::MidKey(const std::string &key1,
@@ -291,8 +576,9 @@ std::string PersistentList::MidKey(const std::string &key1,
     key2Data[i] = (int)(key2Seq[i] - START_SYM - 1);
   }
 
-  long long diff = 0;
-  long long posVal = 1;
+  // half of key2 - key1, a digit at a time: the keys grow without bound
+  // (the common prefix gives zero digits)
+  vector<int> offsetData(maxKeyLen, 0);
   for (int i = maxKeyLen - 1, carry = 0; i >= 0; i--) {
     int val = key2Data[i] - key1Data[i] - carry;
     carry = 0;
@@ -300,24 +586,21 @@ std::string PersistentList::MidKey(const std::string &key1,
       val += KEY_BASE;
       carry = 1;
     }
-    diff += val * posVal;
-    posVal *= KEY_BASE;
+    offsetData[i] = val;
   }
 
-  long long offset = diff / 2;
-  // cout<<"offset:"<<offset<<endl;
-
-  if (offset == 0) {
-    // there is no space, expand the key and return
-    return key1 + MIDDLE_SYM;
+  bool hasOffset = false;
+  for (int i = 0, rem = 0; i < maxKeyLen; i++) {
+    int val = rem * KEY_BASE + offsetData[i];
+    offsetData[i] = val / 2;
+    rem = val % 2;
+    hasOffset = hasOffset || offsetData[i] != 0;
   }
 
-  vector<int> offsetData(maxKeyLen, 0);
-
-  for (int i = maxKeyLen - 1; i >= 0 && offset > 0; i--) {
-    int val = offset % KEY_BASE;
-    offsetData[i] = val;
-    offset /= KEY_BASE;
+  if (!hasOffset) {
+    // there is no space, expand the (padded) key and return
+    key1Seq.resize(maxKeyLen, START_SYM + 1);
+    return mKeyPrefix + key1Seq + MIDDLE_SYM;
   }
 
   vector<int> keyData(maxKeyLen, 0);
@@ -337,4 +620,48 @@ std::string PersistentList::MidKey(const std::string &key1,
   return mKeyPrefix + middleKey;
 }
 
+long long PersistentList::KeySeqToNumber(const char *keySeq,
+                                         size_t length) const {
+  using namespace std;
+  // Only the leading KEY_LEN symbols are used, which keeps the numbers
+  // within a long long.
+  long long num = 0;
+  for (int i = 0; i < KEY_LEN; i++) {
+    int val = i < (int)length ? (int)(keySeq[i] - START_SYM - 1) : 0;
+    num = num * KEY_BASE + max(0, min(val, KEY_BASE - 1));
+  }
+  return num;
+}
+
+void PersistentList::NumberToKeySeq(long long num, char *keySeq) const {
+  for (int i = KEY_LEN - 1; i >= 0; i--) {
+    keySeq[i] = (char)(num % KEY_BASE + START_SYM + 1);
+    num /= KEY_BASE;
+  }
+}
+
+std::vector<std::string>
+PersistentList::SplitKeys(const std::string &firstKey,
+                          const std::string &lastKey, int parts) const {
+  using namespace std;
+  // the split keys need not match any stored item, they only need to be
+  // ordered
+  size_t prefixLen = mKeyPrefix.length();
+  long long first = KeySeqToNumber(firstKey.data() + prefixLen,
+                                   firstKey.length() - prefixLen);
+  long long diff = KeySeqToNumber(lastKey.data() + prefixLen,
+                                  lastKey.length() - prefixLen) -
+                   first;
+  vector<string> splitKeys;
+
+  for (int i = 1; i < parts; i++) {
+    // split diff * i / parts without overflowing
+    long long num = first + (diff / parts) * i + (diff % parts) * i / parts;
+    string keySeq(KEY_LEN, START_SYM + 1);
+    NumberToKeySeq(num, &keySeq[0]);
+    splitKeys.push_back(GetKey(keySeq));
+  }
+  return splitKeys;
+}
+
 PersistentList::~PersistentList() {}
@@ -1,6 +1,8 @@
 #include <leveldb/db.h>
+#include <cstdint>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #pragma once
 
@@ -11,6 +13,10 @@ public:
   static std::shared_ptr<PersistentList> Get(std::shared_ptr<leveldb::DB> db,
                                              const std::string &listName);
 
+  // Like Get, but nullptr instead of creating a list that does not exist
+  static std::shared_ptr<PersistentList>
+  GetExisting(std::shared_ptr<leveldb::DB> db, const std::string &listName);
+
   virtual ~PersistentList();
 
   inline std::string Id() const { return mListId; }
@@ -19,19 +25,32 @@ public:
 
   int Size() const;
 
-  std::string PushFront(const std::string &value);
-  std::string PushBack(const std::string &value);
+  std::string PushFront(const leveldb::Slice &value);
+  std::string PushBack(const leveldb::Slice &value);
+
+  // Reuse the caller's buffer for the new key; false on a failed write
+  bool PushFront(const leveldb::Slice &value, std::string *key);
+  bool PushBack(const leveldb::Slice &value, std::string *key);
+
+  // Appends all the values in one write batch and returns their keys,
+  // none on a failed write
+  std::vector<std::string> PushBack(const std::vector<leveldb::Slice> &values);
 
   std::string InsertAt(const PersistentListIterator *iter,
-                       const std::string &value);
+                       const leveldb::Slice &value);
 
   // TODO - move to optional in C++ 17
   std::pair<bool, std::string> Front() const;
   std::pair<bool, std::string> Back() const;
 
+  // Reuse the caller's buffer; false when the list is empty
+  bool Front(std::string *value) const;
+  bool Back(std::string *value) const;
+
   bool PopFront();
   bool PopBack();
 
+  // False for keys outside the list (the sentinels included)
   bool PopKey(const std::string &key);
   bool PopValue(const std::string &value);
 
@@ -40,10 +59,27 @@ public:
 
   void Compact();
 
+  // Streams the items (from the snapshot, if given) to a flat file and
+  // returns the number of items written.
+  std::pair<bool, int>
+  ExportTo(const std::string &path,
+           const leveldb::Snapshot *snapshot = nullptr) const;
+
+  // Appends the items of an exported file and returns the number of items
+  // imported. With preserveKeys the items keep their original key
+  // sequences, overwriting any item with the same key. On a corrupt file
+  // the items before the corruption remain imported.
+  std::pair<bool, int> ImportFrom(const std::string &path,
+                                  bool preserveKeys = false);
+
   // std::shared_ptr<PersistentListIterator> Iterator();
 
   // The Iterator needs access to the list details
   friend class PersistentListIterator;
+  friend class BufferedPersistentList;
+  friend class PersistentListScanner;
+  friend class DelayQueue;
+  friend class ListServer;
 
 private:
   PersistentList(std::shared_ptr<leveldb::DB> db, const std::string &listName);
@@ -55,9 +91,39 @@ private:
     return mKeyPrefix + keySeq;
   }
 
+  // Whether key lies strictly between the head and tail sentinels
+  bool IsItemKey(const leveldb::Slice &key) const;
+
   std::string NextKey(const std::string &key) const;
   std::string PrevKey(const std::string &key) const;
 
+  // Advance/step back the KEY_LEN symbols at keySeq in place
+  void NextKeySeq(char *keySeq) const;
+  void PrevKeySeq(char *keySeq) const;
+
+  // In-process notification of items added anywhere in the list (waiters
+  // re-check for what they wait for); shared by all instances of the same
+  // list over the same database.
+  struct PushSignal;
+
+  static std::shared_ptr<PushSignal> GetPushSignal(const leveldb::DB *db,
+                                                   const std::string &listId);
+
+  uint64_t PushVersion() const;
+  // Returns false when no push happened after version within the timeout
+  bool WaitForPush(uint64_t version, int timeoutMs) const;
+  void NotifyPush();
+
+  // The leading KEY_LEN symbols of a key sequence as a base KEY_BASE number
+  long long KeySeqToNumber(const char *keySeq, size_t length) const;
+  // Writes num (below KEY_BASE ^ KEY_LEN) as KEY_LEN symbols
+  void NumberToKeySeq(long long num, char *keySeq) const;
+
+  // Returns parts - 1 ascending keys evenly splitting (firstKey, lastKey)
+  std::vector<std::string> SplitKeys(const std::string &firstKey,
+                                     const std::string &lastKey,
+                                     int parts) const;
+
 public:
   std::string MidKey(const std::string &key1, const std::string &key2) const;
 
@@ -70,8 +136,12 @@ private:
   static constexpr int ASCII_OFFSET = 34;
   static constexpr const char *KEY_PREFIX = "pl/";
   static constexpr const char *INIT_KEY_SEQ = "NNNNNNNN";
+  static constexpr const char *EXPORT_MAGIC = "PLX1";
+  static constexpr int EXPORT_BLOCK_SIZE = 1 << 20;
+  static constexpr int IMPORT_BATCH_SIZE = 4 << 20;
 
   std::shared_ptr<leveldb::DB> mDB;
+  std::shared_ptr<PushSignal> mPushSignal;
 
   std::string mListName;
   std::string mListId;
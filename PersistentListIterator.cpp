@@ -2,6 +2,8 @@
 #include "PersistentListIterator.h"
 #include "PersistentList.h"
 
+#include <chrono>
+
 using namespace std;
 
 PersistentListIterator::PersistentListIterator(
@@ -26,22 +28,32 @@ std::string PersistentListIterator::Value() const {
   return mIter->value().ToString();
 }
 
+leveldb::Slice PersistentListIterator::KeySlice() const {
+  assert(mValid);
+  return mIter->key();
+}
+
+leveldb::Slice PersistentListIterator::ValueSlice() const {
+  assert(mValid);
+  return mIter->value();
+}
+
 bool PersistentListIterator::Next() {
   assert(mIter->Valid());
-  mValid = mList->mTailKey.compare(mIter->key().ToString()) != 0;
+  mValid = mIter->key() != mList->mTailKey;
   if (mValid) {
     mIter->Next();
-    mValid = mList->mTailKey.compare(mIter->key().ToString()) != 0;
+    mValid = mIter->key() != mList->mTailKey;
   }
   return mValid;
 }
 
 bool PersistentListIterator::Prev() {
   assert(mIter->Valid());
-  mValid = mList->mHeadKey.compare(mIter->key().ToString()) != 0;
+  mValid = mIter->key() != mList->mHeadKey;
   if (mValid) {
     mIter->Prev();
-    mValid = mList->mHeadKey.compare(mIter->key().ToString()) != 0;
+    mValid = mIter->key() != mList->mHeadKey;
   }
   return mValid;
 }
@@ -55,3 +67,53 @@ void PersistentListIterator::SeekBack() {
   mIter->Seek(mList->mTailKey);
   mValid = false;
 }
+
+bool PersistentListIterator::Seek(const std::string &key) {
+  // keys outside the list stop at its ends, not in the next list
+  if (key.compare(mList->mTailKey) >= 0)
+    mIter->Seek(mList->mTailKey);
+  else if (key.compare(mList->mHeadKey) > 0)
+    mIter->Seek(key);
+  else
+    mIter->Seek(mList->mHeadKey);
+
+  if (!mIter->Valid()) {
+    mValid = false;
+    return false;
+  }
+  if (mIter->key() == mList->mHeadKey)
+    mIter->Next();
+  mValid = mIter->key() != mList->mTailKey;
+  return mValid;
+}
+
+bool PersistentListIterator::WaitNext(int timeoutMs) {
+  if (Next())
+    return true;
+
+  // past the end of the iterator's view, resume after its last item
+  mIter->Prev();
+  string lastKey = mIter->key().ToString();
+  auto deadline =
+      chrono::steady_clock::now() + chrono::milliseconds(timeoutMs);
+
+  while (true) {
+    // taken before the refresh, a push in between ends the wait at once
+    uint64_t version = mList->PushVersion();
+
+    mIter.reset(mList->mDB->NewIterator(mList->mReadOptions));
+    mIter->Seek(lastKey);
+    if (mIter->key() == lastKey)
+      mIter->Next();
+
+    mValid = mIter->key() != mList->mTailKey;
+    if (mValid)
+      return true;
+
+    auto remaining = chrono::duration_cast<chrono::milliseconds>(
+        deadline - chrono::steady_clock::now());
+    if (remaining.count() <= 0 ||
+        !mList->WaitForPush(version, (int)remaining.count()))
+      return false;
+  }
+}
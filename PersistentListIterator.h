@@ -17,12 +17,26 @@ public:
   std::string Key() const;
   std::string Value() const;
 
+  // Valid until the iterator moves
+  leveldb::Slice KeySlice() const;
+  leveldb::Slice ValueSlice() const;
+
   bool Next();
   bool Prev();
 
   void SeekFront();
   void SeekBack();
 
+  // Positions at the first item with key >= the given item key
+  bool Seek(const std::string &key);
+
+  // Follow mode (tail -f): moves to the next item, waiting up to the
+  // timeout for one to be pushed at the back of the list in this process.
+  // Needs a positioned iterator; SeekBack() follows only the new items.
+  // A push that reuses the key of the last item seen (after a PopBack) is
+  // not reported.
+  bool WaitNext(int timeoutMs);
+
   std::string ListId() const;
 
 private:
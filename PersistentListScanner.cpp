@@ -0,0 +1,172 @@
+#include "PersistentListScanner.h"
+#include "PersistentList.h"
+#include "leveldb/write_batch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <thread>
+
+using namespace std;
+
+PersistentListScanner::PersistentListScanner(
+    std::shared_ptr<PersistentList> list, int partitions, int threads)
+    : mList(list), mPartitions(max(1, partitions)), mThreads(threads) {
+  if (mThreads <= 0)
+    mThreads = max(1, (int)thread::hardware_concurrency());
+  mThreads = min(mThreads, mPartitions);
+}
+
+PersistentListScanner::~PersistentListScanner() {}
+
+std::vector<std::string> PersistentListScanner::PartitionKeys() const {
+  return PartitionKeys(mList->mReadOptions);
+}
+
+std::vector<std::string> PersistentListScanner::PartitionKeys(
+    const leveldb::ReadOptions &readOptions) const {
+  auto iter =
+      unique_ptr<leveldb::Iterator>(mList->mDB->NewIterator(readOptions));
+  iter->Seek(mList->mHeadKey);
+  iter->Next();
+  string firstKey = iter->key().ToString();
+  iter->Seek(mList->mTailKey);
+  iter->Prev();
+  string lastKey = iter->key().ToString();
+
+  vector<string> keys(1, mList->mHeadKey);
+
+  if (mPartitions > 1 && mList->mTailKey.compare(firstKey) != 0) {
+    // Cut the key range into a fine grid and let the database tell how
+    // the data is spread over it.
+    int gridSize = mPartitions * GRID_FACTOR;
+    vector<string> grid = mList->SplitKeys(firstKey, lastKey, gridSize);
+    grid.insert(grid.begin(), mList->mHeadKey);
+    grid.push_back(mList->mTailKey);
+
+    vector<leveldb::Range> ranges;
+    for (int i = 0; i < gridSize; i++)
+      ranges.push_back(leveldb::Range(grid[i], grid[i + 1]));
+
+    vector<uint64_t> sizes(gridSize, 0);
+    mList->mDB->GetApproximateSizes(ranges.data(), gridSize, sizes.data());
+
+    uint64_t total = 0;
+    for (uint64_t size : sizes)
+      total += size;
+
+    if (total == 0) {
+      // nothing on disk yet (e.g. all in the memtable), use the key span
+      for (int i = 1; i < mPartitions; i++)
+        keys.push_back(grid[i * GRID_FACTOR]);
+    } else {
+      uint64_t sum = 0;
+      for (int i = 0; i < gridSize - 1; i++) {
+        sum += sizes[i];
+        int part = (int)keys.size();
+        if (part < mPartitions && sum * mPartitions >= total * part)
+          keys.push_back(grid[i + 1]);
+      }
+      while ((int)keys.size() < mPartitions)
+        keys.push_back(grid[gridSize]);
+    }
+  }
+
+  while ((int)keys.size() < mPartitions)
+    keys.push_back(mList->mHeadKey);
+
+  keys.push_back(mList->mTailKey);
+  return keys;
+}
+
+void PersistentListScanner::ScanPartition(
+    const leveldb::ReadOptions &readOptions, const std::string &startKey,
+    const std::string &endKey, int partition, const ScanFunc &func) const {
+  auto iter =
+      unique_ptr<leveldb::Iterator>(mList->mDB->NewIterator(readOptions));
+  leveldb::Slice endSlice(endKey);
+  iter->Seek(startKey);
+
+  if (iter->Valid() && iter->key().compare(mList->mHeadKey) == 0)
+    iter->Next();
+
+  for (; iter->Valid() && iter->key().compare(endSlice) < 0; iter->Next())
+    func(partition, iter->key(), iter->value());
+}
+
+void PersistentListScanner::Scan(const ScanFunc &func) {
+  leveldb::ReadOptions readOptions = mList->mReadOptions;
+  readOptions.snapshot = mList->mDB->GetSnapshot();
+  // a one-off full scan should not evict the hot blocks
+  readOptions.fill_cache = false;
+
+  vector<string> keys = PartitionKeys(readOptions);
+  atomic<int> nextPartition(0);
+
+  auto worker = [&]() {
+    for (int part = nextPartition++; part < mPartitions;
+         part = nextPartition++) {
+      ScanPartition(readOptions, keys[part], keys[part + 1], part, func);
+    }
+  };
+
+  vector<thread> threads;
+  for (int i = 1; i < mThreads; i++)
+    threads.push_back(thread(worker));
+  worker();
+
+  for (auto &t : threads)
+    t.join();
+
+  mList->mDB->ReleaseSnapshot(readOptions.snapshot);
+}
+
+int PersistentListScanner::Count() {
+  vector<int> counts(mPartitions, 0);
+  Scan([&counts](int partition, const leveldb::Slice & /*key*/,
+                 const leveldb::Slice & /*value*/) { counts[partition]++; });
+
+  int count = 0;
+  for (int c : counts)
+    count += c;
+  return count;
+}
+
+int PersistentListScanner::PopValue(const std::string &value) {
+  leveldb::Slice valueSlice(value);
+  return PopIf(
+      [&valueSlice](const leveldb::Slice &v) { return v == valueSlice; });
+}
+
+int PersistentListScanner::PopIf(const PredicateFunc &pred) {
+  struct PartitionBatch {
+    leveldb::WriteBatch batch;
+    int pending = 0;
+    int deleted = 0;
+  };
+  vector<PartitionBatch> batches(mPartitions);
+  leveldb::DB *db = mList->mDB.get();
+  const leveldb::WriteOptions &writeOptions = mList->mWriteOptions;
+
+  Scan([&](int partition, const leveldb::Slice &key,
+           const leveldb::Slice &value) {
+    if (!pred(value))
+      return;
+    PartitionBatch &pb = batches[partition];
+    pb.batch.Delete(key);
+    pb.deleted++;
+    if (++pb.pending == BATCH_SIZE) {
+      db->Write(writeOptions, &pb.batch);
+      pb.batch.Clear();
+      pb.pending = 0;
+    }
+  });
+
+  int deleted = 0;
+  for (auto &pb : batches) {
+    if (pb.pending > 0)
+      db->Write(writeOptions, &pb.batch);
+    deleted += pb.deleted;
+  }
+  return deleted;
+}
@@ -0,0 +1,64 @@
+#include <leveldb/db.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#pragma once
+
+class PersistentList;
+
+// Splits a list into key ranges of about the same size and scans them in
+// parallel, each partition with its own database iterator. All partitions
+// of one call read from the same snapshot.
+class PersistentListScanner {
+public:
+  // Called concurrently from the worker threads, but never concurrently
+  // for the same partition.
+  typedef std::function<void(int partition, const leveldb::Slice &key,
+                             const leveldb::Slice &value)>
+      ScanFunc;
+  // Called concurrently from the worker threads, like ScanFunc
+  typedef std::function<bool(const leveldb::Slice &value)> PredicateFunc;
+
+  // threads = 0 uses the hardware concurrency
+  PersistentListScanner(std::shared_ptr<PersistentList> list, int partitions,
+                        int threads = 0);
+
+  virtual ~PersistentListScanner();
+
+  inline int Partitions() const { return mPartitions; }
+
+  void Scan(const ScanFunc &func);
+
+  int Count();
+
+  int PopValue(const std::string &value);
+
+  // Removes the items the predicate holds for; the predicate must be
+  // safe to call from several threads at once.
+  int PopIf(const PredicateFunc &pred);
+
+  // Partition boundaries: Partitions() + 1 keys from the head to the tail
+  std::vector<std::string> PartitionKeys() const;
+
+private:
+  PersistentListScanner(const PersistentListScanner &) = delete;
+  PersistentListScanner &operator=(const PersistentListScanner &) = delete;
+
+  std::vector<std::string>
+  PartitionKeys(const leveldb::ReadOptions &readOptions) const;
+
+  void ScanPartition(const leveldb::ReadOptions &readOptions,
+                     const std::string &startKey, const std::string &endKey,
+                     int partition, const ScanFunc &func) const;
+
+private:
+  // candidate split points per partition, sized with GetApproximateSizes
+  static constexpr int GRID_FACTOR = 16;
+  static constexpr int BATCH_SIZE = 1024;
+
+  std::shared_ptr<PersistentList> mList;
+  int mPartitions;
+  int mThreads;
+};
@@ -0,0 +1,196 @@
+#include "SortedPersistentList.h"
+#include "PersistentList.h"
+#include "PersistentListIterator.h"
+#include "leveldb/write_batch.h"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace std;
+
+std::shared_ptr<SortedPersistentList>
+SortedPersistentList::Get(std::shared_ptr<leveldb::DB> db,
+                          const std::string &listName, LessFunc less) {
+  return std::shared_ptr<SortedPersistentList>(
+      new SortedPersistentList(db, listName, less));
+}
+
+SortedPersistentList::LessFunc
+SortedPersistentList::ByKey(SortKeyFunc sortKey) {
+  return [sortKey](const string &a, const string &b) {
+    return sortKey(a) < sortKey(b);
+  };
+}
+
+SortedPersistentList::SortedPersistentList(std::shared_ptr<leveldb::DB> db,
+                                           const std::string &listName,
+                                           LessFunc less)
+    : mDB(db), mList(PersistentList::Get(db, listName)), mLess(less) {
+  if (!mLess) {
+    mLess = [](const string &a, const string &b) { return a < b; };
+  }
+  mFencePrefix = FENCE_PREFIX + mList->Id() + "/";
+
+  auto iter = unique_ptr<leveldb::Iterator>(mDB->NewIterator(mReadOptions));
+  leveldb::Slice prefix(mFencePrefix);
+
+  for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix);
+       iter->Next()) {
+    string itemKey = iter->key().ToString().substr(mFencePrefix.length());
+    mFences.push_back(make_pair(itemKey, iter->value().ToString()));
+  }
+}
+
+SortedPersistentList::~SortedPersistentList() {}
+
+int SortedPersistentList::Size() const { return mList->Size(); }
+
+int SortedPersistentList::Seek(PersistentListIterator *iter,
+                               const std::string &value, bool upper) const {
+  typedef pair<string, string> Fence;
+  vector<Fence>::const_iterator fence;
+
+  // first fence past the position, the scan starts from the one before
+  if (upper) {
+    fence = upper_bound(mFences.begin(), mFences.end(), value,
+                        [this](const string &v, const Fence &f) {
+                          return mLess(v, f.second);
+                        });
+  } else {
+    fence = lower_bound(mFences.begin(), mFences.end(), value,
+                        [this](const Fence &f, const string &v) {
+                          return mLess(f.second, v);
+                        });
+  }
+
+  if (fence == mFences.begin()) {
+    iter->SeekFront();
+    iter->Next();
+  } else {
+    iter->Seek((fence - 1)->first);
+  }
+
+  int skipped = 0;
+  while (iter->Valid() && (upper ? !mLess(value, iter->Value())
+                                 : mLess(iter->Value(), value))) {
+    iter->Next();
+    skipped++;
+  }
+  return skipped;
+}
+
+std::string SortedPersistentList::InsertSorted(const std::string &value) {
+  PersistentListIterator iter(mList);
+  int skipped = Seek(&iter, value, true);
+
+  string key = iter.Valid() ? mList->InsertAt(&iter, value)
+                            : mList->PushBack(value);
+
+  // keep the scans short: a long walk makes the new item a fence
+  if (skipped >= FENCE_INTERVAL)
+    AddFence(key, value);
+  return key;
+}
+
+bool SortedPersistentList::LowerBound(PersistentListIterator *iter,
+                                      const std::string &value) const {
+  assert(iter->ListId().compare(mList->Id()) == 0);
+  Seek(iter, value, false);
+  return iter->Valid();
+}
+
+bool SortedPersistentList::UpperBound(PersistentListIterator *iter,
+                                      const std::string &value) const {
+  assert(iter->ListId().compare(mList->Id()) == 0);
+  Seek(iter, value, true);
+  return iter->Valid();
+}
+
+std::pair<bool, std::string> SortedPersistentList::Min() const {
+  return mList->Front();
+}
+
+std::pair<bool, std::string> SortedPersistentList::Max() const {
+  return mList->Back();
+}
+
+std::pair<bool, std::string> SortedPersistentList::PopMin() {
+  PersistentListIterator iter(mList);
+  iter.SeekFront();
+
+  if (!iter.Next())
+    return pair<bool, string>(false, "");
+
+  string value = iter.Value();
+  PopKey(iter.Key());
+  return pair<bool, string>(true, value);
+}
+
+std::pair<bool, std::string> SortedPersistentList::PopMax() {
+  PersistentListIterator iter(mList);
+  iter.SeekBack();
+
+  if (!iter.Prev())
+    return pair<bool, string>(false, "");
+
+  string value = iter.Value();
+  PopKey(iter.Key());
+  return pair<bool, string>(true, value);
+}
+
+bool SortedPersistentList::PopKey(const std::string &key) {
+  // a fence must not outlive its item, a new item may reuse the key
+  DropFence(key);
+  return mList->PopKey(key);
+}
+
+void SortedPersistentList::Clear() {
+  leveldb::WriteBatch batch;
+  for (auto &fence : mFences)
+    batch.Delete(GetFenceKey(fence.first));
+  mDB->Write(mWriteOptions, &batch);
+  mFences.clear();
+
+  mList->Clear();
+}
+
+void SortedPersistentList::RebuildIndex() {
+  leveldb::WriteBatch batch;
+  for (auto &fence : mFences)
+    batch.Delete(GetFenceKey(fence.first));
+  mFences.clear();
+
+  PersistentListIterator iter(mList);
+  iter.SeekFront();
+
+  for (int i = 1; iter.Next(); i++) {
+    if (i % FENCE_INTERVAL == 0) {
+      mFences.push_back(make_pair(iter.Key(), iter.Value()));
+      batch.Put(GetFenceKey(iter.Key()), iter.Value());
+    }
+  }
+  mDB->Write(mWriteOptions, &batch);
+}
+
+void SortedPersistentList::AddFence(const std::string &itemKey,
+                                    const std::string &value) {
+  auto fence = lower_bound(
+      mFences.begin(), mFences.end(), itemKey,
+      [](const pair<string, string> &f, const string &k) {
+        return f.first < k;
+      });
+  mFences.insert(fence, make_pair(itemKey, value));
+  mDB->Put(mWriteOptions, GetFenceKey(itemKey), value);
+}
+
+void SortedPersistentList::DropFence(const std::string &itemKey) {
+  auto fence = lower_bound(
+      mFences.begin(), mFences.end(), itemKey,
+      [](const pair<string, string> &f, const string &k) {
+        return f.first < k;
+      });
+  if (fence != mFences.end() && fence->first == itemKey) {
+    mFences.erase(fence);
+    mDB->Delete(mWriteOptions, GetFenceKey(itemKey));
+  }
+}
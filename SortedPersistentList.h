@@ -0,0 +1,95 @@
+#include <leveldb/db.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#pragma once
+
+class PersistentList;
+class PersistentListIterator;
+
+// Keeps the items of a list ordered by a comparator. The position for a
+// new item is found with a binary search over a persisted sparse index of
+// sampled item keys (fences), followed by a short scan from the fence.
+//
+// The comparator is not persisted; the same one has to be supplied every
+// time the list is opened, and the items have to be changed only through
+// this class to keep the order and the index intact.
+class SortedPersistentList {
+public:
+  typedef std::function<bool(const std::string &a, const std::string &b)>
+      LessFunc;
+  typedef std::function<std::string(const std::string &value)> SortKeyFunc;
+
+  // An empty comparator orders the values bytewise
+  static std::shared_ptr<SortedPersistentList>
+  Get(std::shared_ptr<leveldb::DB> db, const std::string &listName,
+      LessFunc less = LessFunc());
+
+  // Orders values by the key extracted from them
+  static LessFunc ByKey(SortKeyFunc sortKey);
+
+  virtual ~SortedPersistentList();
+
+  inline std::shared_ptr<PersistentList> List() const { return mList; }
+
+  int Size() const;
+
+  // Equal values are kept in insertion order
+  std::string InsertSorted(const std::string &value);
+
+  // Position the iterator at the first item not less than / greater than
+  // the value; returns false when there is no such item.
+  bool LowerBound(PersistentListIterator *iter,
+                  const std::string &value) const;
+  bool UpperBound(PersistentListIterator *iter,
+                  const std::string &value) const;
+
+  std::pair<bool, std::string> Min() const;
+  std::pair<bool, std::string> Max() const;
+
+  std::pair<bool, std::string> PopMin();
+  std::pair<bool, std::string> PopMax();
+
+  bool PopKey(const std::string &key);
+
+  void Clear();
+
+  // Resamples the index from the list items
+  void RebuildIndex();
+
+private:
+  SortedPersistentList(std::shared_ptr<leveldb::DB> db,
+                       const std::string &listName, LessFunc less);
+
+  SortedPersistentList(const SortedPersistentList &list) = delete;
+  SortedPersistentList &operator=(const SortedPersistentList &list) = delete;
+
+  inline std::string GetFenceKey(const std::string &itemKey) const {
+    return mFencePrefix + itemKey;
+  }
+
+  // Scans from the closest fence; returns the number of items skipped
+  int Seek(PersistentListIterator *iter, const std::string &value,
+           bool upper) const;
+
+  void AddFence(const std::string &itemKey, const std::string &value);
+  void DropFence(const std::string &itemKey);
+
+private:
+  static constexpr int FENCE_INTERVAL = 64;
+  static constexpr const char *FENCE_PREFIX = "pf/";
+
+  std::shared_ptr<leveldb::DB> mDB;
+  std::shared_ptr<PersistentList> mList;
+  LessFunc mLess;
+
+  // item key -> value, in list order
+  std::vector<std::pair<std::string, std::string>> mFences;
+  std::string mFencePrefix;
+
+  leveldb::WriteOptions mWriteOptions;
+  leveldb::ReadOptions mReadOptions;
+};
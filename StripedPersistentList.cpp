@@ -0,0 +1,192 @@
+#include "StripedPersistentList.h"
+#include "PersistentList.h"
+#include "PersistentListIterator.h"
+#include <leveldb/write_batch.h>
+
+#include <cassert>
+#include <functional>
+#include <thread>
+
+using namespace std;
+
+constexpr const char *StripedPersistentList::STRIPES_PREFIX;
+
+std::shared_ptr<StripedPersistentList>
+StripedPersistentList::Get(std::shared_ptr<leveldb::DB> db,
+                           const std::string &listName, int stripes) {
+  return std::shared_ptr<StripedPersistentList>(
+      new StripedPersistentList(db, listName, stripes));
+}
+
+StripedPersistentList::StripedPersistentList(std::shared_ptr<leveldb::DB> db,
+                                             const std::string &listName,
+                                             int stripes)
+    : mDB(db), mListName(listName), mSequence(0) {
+  leveldb::WriteOptions writeOptions;
+  leveldb::ReadOptions readOptions;
+
+  string stripesKey = STRIPES_PREFIX + mListName;
+  string stripesValue;
+  leveldb::Status s = mDB->Get(readOptions, stripesKey, &stripesValue);
+
+  if (s.IsNotFound()) {
+    // moved from pl/$LIST_NAME/stripes
+    string oldKey = "pl/" + mListName + "/stripes";
+    leveldb::WriteBatch batch;
+
+    s = mDB->Get(readOptions, oldKey, &stripesValue);
+    if (s.ok())
+      batch.Delete(oldKey);
+    else
+      stripesValue = to_string(max(1, stripes));
+    batch.Put(stripesKey, stripesValue);
+    mDB->Write(writeOptions, &batch);
+  }
+
+  int count = stoi(stripesValue);
+  uint64_t nextSequence = 0;
+
+  for (int i = 0; i < count; i++) {
+    unique_ptr<StripeState> stripe(new StripeState);
+    stripe->list = PersistentList::Get(db, mListName + "#" + to_string(i));
+
+    auto back = stripe->list->Back();
+    if (back.first)
+      nextSequence = max(nextSequence, DecodeSequence(back.second) + 1);
+
+    mStripes.push_back(move(stripe));
+  }
+  mSequence = nextSequence;
+}
+
+StripedPersistentList::~StripedPersistentList() {}
+
+std::shared_ptr<PersistentList>
+StripedPersistentList::Stripe(int stripe) const {
+  return mStripes[stripe]->list;
+}
+
+int StripedPersistentList::Size() const {
+  int count = 0;
+  for (auto &stripe : mStripes)
+    count += stripe->list->Size();
+  return count;
+}
+
+uint64_t StripedPersistentList::PushBack(const std::string &value) {
+  // start from the thread's own stripe and take the first free one
+  int stripes = (int)mStripes.size();
+  int home = (int)(hash<thread::id>()(this_thread::get_id()) % stripes);
+  int index = home;
+  unique_lock<mutex> lock(mStripes[home]->mutex, try_to_lock);
+
+  for (int i = 1; i < stripes && !lock.owns_lock(); i++) {
+    index = (home + i) % stripes;
+    lock = unique_lock<mutex>(mStripes[index]->mutex, try_to_lock);
+  }
+
+  if (!lock.owns_lock()) {
+    index = home;
+    lock = unique_lock<mutex>(mStripes[home]->mutex);
+  }
+
+  // taken under the stripe lock, so each stripe stays in sequence order
+  uint64_t sequence = mSequence++;
+  mStripes[index]->list->PushBack(EncodeValue(sequence, value));
+  return sequence;
+}
+
+int StripedPersistentList::FrontStripe() {
+  int front = -1;
+  uint64_t frontSequence = 0;
+
+  for (int i = 0; i < (int)mStripes.size(); i++) {
+    StripeState &stripe = *mStripes[i];
+
+    // only the consumers remove items, so a known front stays valid
+    if (!stripe.hasFront) {
+      PersistentListIterator iter(stripe.list);
+      iter.SeekFront();
+      if (iter.Next()) {
+        stripe.hasFront = true;
+        stripe.frontKey = iter.Key();
+        stripe.frontValue = iter.Value();
+      }
+    }
+
+    if (stripe.hasFront) {
+      uint64_t sequence = DecodeSequence(stripe.frontValue);
+      if (front < 0 || sequence < frontSequence) {
+        front = i;
+        frontSequence = sequence;
+      }
+    }
+  }
+  return front;
+}
+
+std::pair<bool, std::string> StripedPersistentList::Front() {
+  lock_guard<mutex> popLock(mPopMutex);
+  int front = FrontStripe();
+
+  if (front < 0)
+    return pair<bool, string>(false, "");
+
+  return pair<bool, string>(
+      true, DecodeValue(mStripes[front]->frontValue).ToString());
+}
+
+bool StripedPersistentList::PopFront(std::string *value) {
+  lock_guard<mutex> popLock(mPopMutex);
+  int front = FrontStripe();
+
+  if (front < 0)
+    return false;
+
+  StripeState &stripe = *mStripes[front];
+  if (value != nullptr)
+    *value = DecodeValue(stripe.frontValue).ToString();
+
+  bool popped;
+  {
+    lock_guard<mutex> lock(stripe.mutex);
+    popped = stripe.list->PopKey(stripe.frontKey);
+  }
+  stripe.hasFront = false;
+  return popped;
+}
+
+void StripedPersistentList::Clear() {
+  lock_guard<mutex> popLock(mPopMutex);
+
+  for (auto &stripe : mStripes) {
+    lock_guard<mutex> lock(stripe->mutex);
+    stripe->list->Clear();
+    stripe->hasFront = false;
+  }
+}
+
+std::string StripedPersistentList::EncodeValue(uint64_t sequence,
+                                               const std::string &value) {
+  // big endian, so the encoded sequences also sort bytewise
+  string itemValue(SEQ_LEN, '\0');
+  for (int i = SEQ_LEN - 1; i >= 0; i--) {
+    itemValue[i] = (char)(sequence & 0xFF);
+    sequence >>= 8;
+  }
+  itemValue.append(value);
+  return itemValue;
+}
+
+uint64_t StripedPersistentList::DecodeSequence(const leveldb::Slice &itemValue) {
+  assert(itemValue.size() >= SEQ_LEN);
+  uint64_t sequence = 0;
+  for (int i = 0; i < SEQ_LEN; i++)
+    sequence = (sequence << 8) | (uint8_t)itemValue[i];
+  return sequence;
+}
+
+leveldb::Slice StripedPersistentList::DecodeValue(const leveldb::Slice &itemValue) {
+  assert(itemValue.size() >= SEQ_LEN);
+  return leveldb::Slice(itemValue.data() + SEQ_LEN, itemValue.size() - SEQ_LEN);
+}
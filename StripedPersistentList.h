@@ -0,0 +1,90 @@
+#include <leveldb/db.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#pragma once
+
+class PersistentList;
+
+// Spreads one logical list over a number of PersistentList stripes so that
+// producers on different threads append to different key ranges. Every
+// item is tagged with a global sequence number at push; consumers merge
+// the stripes back into that order.
+//
+// The order is global over the items already pushed: a push still in
+// progress on one stripe may end up before an item just popped from
+// another one.
+//
+// The sequence counter and the stripe fronts seen by the consumers are
+// cached in the instance: all producers and consumers of a striped list
+// must share one instance per database.
+class StripedPersistentList {
+public:
+  // The stripe count of an existing list is kept from its creation
+  static std::shared_ptr<StripedPersistentList>
+  Get(std::shared_ptr<leveldb::DB> db, const std::string &listName,
+      int stripes);
+
+  virtual ~StripedPersistentList();
+
+  inline std::string Name() const { return mListName; }
+  inline int Stripes() const { return (int)mStripes.size(); }
+
+  std::shared_ptr<PersistentList> Stripe(int stripe) const;
+
+  int Size() const;
+
+  // Returns the sequence number of the item; safe to call concurrently
+  uint64_t PushBack(const std::string &value);
+
+  std::pair<bool, std::string> Front();
+
+  // Pops the item with the lowest sequence number, returning its value
+  bool PopFront(std::string *value = nullptr);
+
+  void Clear();
+
+  // Item values in the stripes are prefixed with the sequence number
+  static std::string EncodeValue(uint64_t sequence, const std::string &value);
+  static uint64_t DecodeSequence(const leveldb::Slice &itemValue);
+  static leveldb::Slice DecodeValue(const leveldb::Slice &itemValue);
+
+private:
+  StripedPersistentList(std::shared_ptr<leveldb::DB> db,
+                        const std::string &listName, int stripes);
+
+  StripedPersistentList(const StripedPersistentList &list) = delete;
+  StripedPersistentList &operator=(const StripedPersistentList &list) = delete;
+
+  // Returns the stripe holding the lowest sequence number at the front, or
+  // -1 when all stripes are empty. Needs mPopMutex.
+  int FrontStripe();
+
+private:
+  static constexpr int SEQ_LEN = 8;
+  // stripe counts live apart from the list keys: a numeric list name
+  // would fall in the key range of the list with that id
+  static constexpr const char *STRIPES_PREFIX = "ps/";
+
+  struct StripeState {
+    std::shared_ptr<PersistentList> list;
+    // serializes the pushes (and pops) on this stripe
+    std::mutex mutex;
+
+    // front item as seen by the consumers, guarded by mPopMutex
+    bool hasFront = false;
+    std::string frontKey;
+    std::string frontValue;
+  };
+
+  std::shared_ptr<leveldb::DB> mDB;
+  std::string mListName;
+  std::vector<std::unique_ptr<StripeState>> mStripes;
+  std::atomic<uint64_t> mSequence;
+  std::mutex mPopMutex;
+};
@@ -0,0 +1,72 @@
+#include "StripedPersistentListIterator.h"
+#include "PersistentListIterator.h"
+#include "StripedPersistentList.h"
+
+#include <cassert>
+
+using namespace std;
+
+StripedPersistentListIterator::StripedPersistentListIterator(
+    std::shared_ptr<StripedPersistentList> list)
+    : mValid(false), mCurrent(-1), mList(list) {
+  for (int i = 0; i < mList->Stripes(); i++) {
+    mIters.push_back(unique_ptr<PersistentListIterator>(
+        new PersistentListIterator(mList->Stripe(i))));
+  }
+}
+
+StripedPersistentListIterator::~StripedPersistentListIterator() {}
+
+bool StripedPersistentListIterator::Valid() const { return mValid; }
+
+std::string StripedPersistentListIterator::Key() const {
+  assert(mValid);
+  return mIters[mCurrent]->Key();
+}
+
+std::string StripedPersistentListIterator::Value() const {
+  assert(mValid);
+  return StripedPersistentList::DecodeValue(mIters[mCurrent]->Value())
+      .ToString();
+}
+
+uint64_t StripedPersistentListIterator::Sequence() const {
+  assert(mValid);
+  return StripedPersistentList::DecodeSequence(mIters[mCurrent]->Value());
+}
+
+int StripedPersistentListIterator::Stripe() const {
+  assert(mValid);
+  return mCurrent;
+}
+
+bool StripedPersistentListIterator::Next() {
+  if (mCurrent >= 0 && mIters[mCurrent]->Next()) {
+    mHeap.push(HeapEntry(
+        StripedPersistentList::DecodeSequence(mIters[mCurrent]->Value()),
+        mCurrent));
+  }
+
+  mValid = !mHeap.empty();
+  mCurrent = -1;
+
+  if (mValid) {
+    mCurrent = mHeap.top().second;
+    mHeap.pop();
+  }
+  return mValid;
+}
+
+void StripedPersistentListIterator::SeekFront() {
+  mHeap = decltype(mHeap)();
+
+  for (int i = 0; i < (int)mIters.size(); i++) {
+    mIters[i]->SeekFront();
+    if (mIters[i]->Next()) {
+      mHeap.push(HeapEntry(
+          StripedPersistentList::DecodeSequence(mIters[i]->Value()), i));
+    }
+  }
+  mValid = false;
+  mCurrent = -1;
+}
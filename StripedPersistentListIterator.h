@@ -0,0 +1,50 @@
+#include <leveldb/db.h>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#pragma once
+
+class PersistentListIterator;
+class StripedPersistentList;
+
+// Iterates over the items of all stripes in sequence order, merging the
+// stripe iterators through a heap.
+class StripedPersistentListIterator {
+public:
+  StripedPersistentListIterator(std::shared_ptr<StripedPersistentList> list);
+
+  virtual ~StripedPersistentListIterator();
+
+  bool Valid() const;
+
+  // Key of the item in its stripe
+  std::string Key() const;
+  std::string Value() const;
+  uint64_t Sequence() const;
+  int Stripe() const;
+
+  bool Next();
+
+  void SeekFront();
+
+private:
+  StripedPersistentListIterator(const StripedPersistentListIterator &) =
+      delete;
+  StripedPersistentListIterator &
+  operator=(const StripedPersistentListIterator &) = delete;
+
+private:
+  typedef std::pair<uint64_t, int> HeapEntry;
+
+  bool mValid;
+  int mCurrent;
+  std::shared_ptr<StripedPersistentList> mList;
+  std::vector<std::unique_ptr<PersistentListIterator>> mIters;
+  std::priority_queue<HeapEntry, std::vector<HeapEntry>,
+                      std::greater<HeapEntry>>
+      mHeap;
+};
@@ -0,0 +1,128 @@
+#include "ListCodec.h"
+#include "PersistentList.h"
+#include "PersistentListIterator.h"
+#include <memory>
+#include <string>
+#include <utility>
+
+#pragma once
+
+template <typename T, typename Codec> class TypedPersistentListIterator;
+
+// A PersistentList of T values, encoded and decoded by the Codec. Values
+// go to the database straight from the codec's slice, and are decoded
+// straight from the database iterator, without intermediate strings.
+template <typename T, typename Codec = ListCodec<T>>
+class TypedPersistentList {
+public:
+  static std::shared_ptr<TypedPersistentList>
+  Get(std::shared_ptr<leveldb::DB> db, const std::string &listName) {
+    return std::shared_ptr<TypedPersistentList>(
+        new TypedPersistentList(PersistentList::Get(db, listName)));
+  }
+
+  virtual ~TypedPersistentList() {}
+
+  inline std::shared_ptr<PersistentList> List() const { return mList; }
+
+  int Size() const { return mList->Size(); }
+
+  std::string PushFront(const T &value) {
+    return mList->PushFront(Codec::Encode(value, &mBuffer));
+  }
+
+  std::string PushBack(const T &value) {
+    return mList->PushBack(Codec::Encode(value, &mBuffer));
+  }
+
+  std::string InsertAt(const TypedPersistentListIterator<T, Codec> *iter,
+                       const T &value) {
+    return mList->InsertAt(iter->Base(), Codec::Encode(value, &mBuffer));
+  }
+
+  // Also false when the stored value does not decode
+  std::pair<bool, T> Front() const {
+    PersistentListIterator iter(mList);
+    iter.SeekFront();
+    return Decode(iter.Next(), iter);
+  }
+
+  std::pair<bool, T> Back() const {
+    PersistentListIterator iter(mList);
+    iter.SeekBack();
+    return Decode(iter.Prev(), iter);
+  }
+
+  bool PopFront() { return mList->PopFront(); }
+  bool PopBack() { return mList->PopBack(); }
+
+  bool PopKey(const std::string &key) { return mList->PopKey(key); }
+
+  void Clear() { mList->Clear(); }
+
+private:
+  explicit TypedPersistentList(std::shared_ptr<PersistentList> list)
+      : mList(list) {}
+
+  TypedPersistentList(const TypedPersistentList &list) = delete;
+  TypedPersistentList &operator=(const TypedPersistentList &list) = delete;
+
+  static std::pair<bool, T> Decode(bool valid,
+                                   const PersistentListIterator &iter) {
+    std::pair<bool, T> result(false, T());
+    if (valid)
+      result.first = Codec::Decode(iter.ValueSlice(), &result.second);
+    return result;
+  }
+
+private:
+  std::shared_ptr<PersistentList> mList;
+  // reused by the codecs that need to encode into a buffer
+  std::string mBuffer;
+};
+
+template <typename T, typename Codec = ListCodec<T>>
+class TypedPersistentListIterator {
+public:
+  TypedPersistentListIterator(
+      std::shared_ptr<TypedPersistentList<T, Codec>> list)
+      : mIter(list->List()) {}
+
+  virtual ~TypedPersistentListIterator() {}
+
+  bool Valid() const { return mIter.Valid(); }
+
+  std::string Key() const { return mIter.Key(); }
+
+  // Decodes from the database iterator's value; false when it does not
+  // decode
+  bool Value(T *value) const {
+    return Codec::Decode(mIter.ValueSlice(), value);
+  }
+
+  std::pair<bool, T> Value() const {
+    std::pair<bool, T> result(false, T());
+    result.first = Codec::Decode(mIter.ValueSlice(), &result.second);
+    return result;
+  }
+
+  bool Next() { return mIter.Next(); }
+  bool Prev() { return mIter.Prev(); }
+
+  void SeekFront() { mIter.SeekFront(); }
+  void SeekBack() { mIter.SeekBack(); }
+
+  bool Seek(const std::string &key) { return mIter.Seek(key); }
+
+  bool WaitNext(int timeoutMs) { return mIter.WaitNext(timeoutMs); }
+
+  const PersistentListIterator *Base() const { return &mIter; }
+
+private:
+  TypedPersistentListIterator(const TypedPersistentListIterator &) = delete;
+  TypedPersistentListIterator &
+  operator=(const TypedPersistentListIterator &) = delete;
+
+private:
+  PersistentListIterator mIter;
+};
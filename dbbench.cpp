@@ -0,0 +1,189 @@
+#include "leveldb/db.h"
+#include "BufferedPersistentList.h"
+#include "ListClient.h"
+#include "ListServer.h"
+#include "MemoryDB.h"
+#include "PersistentList.h"
+#include "StripedPersistentList.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Usage: dbbench [items] [value size]
+
+namespace {
+
+void Report(const char *name, int items, uint64_t bytes,
+            const std::function<void()> &func) {
+  auto start = std::chrono::steady_clock::now();
+  func();
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  double secs = elapsed.count() > 0 ? elapsed.count() : 1e-9;
+  printf("%-24s %10d items %10.1f ms %12.0f items/s %8.1f MB/s\n", name,
+         items, secs * 1000, items / secs, bytes / secs / (1 << 20));
+}
+
+// Benchmarks on a failed setup would only report noise
+void Check(bool ok, const std::string &what) {
+  if (!ok) {
+    fprintf(stderr, "dbbench: %s failed\n", what.c_str());
+    exit(1);
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const int items = argc > 1 ? atoi(argv[1]) : 1000000;
+  const int valueSize = argc > 2 ? atoi(argv[2]) : 100;
+  const uint64_t bytes = (uint64_t)items * valueSize;
+  const std::string exportPath = "./benchdb.export";
+
+  leveldb::DB *db;
+  leveldb::Options options;
+  options.create_if_missing = true;
+  leveldb::Status openStatus = leveldb::DB::Open(options, "./benchdb", &db);
+  Check(openStatus.ok(), "opening ./benchdb: " + openStatus.ToString());
+  std::shared_ptr<leveldb::DB> spDB(db);
+
+  auto source = PersistentList::Get(spDB, "bench_source");
+  auto target = PersistentList::Get(spDB, "bench_target");
+  source->Clear();
+  target->Clear();
+
+  std::string value(valueSize, 'x');
+
+  Report("PushBack", items, bytes, [&]() {
+    for (int i = 0; i < items; i++)
+      source->PushBack(value);
+  });
+
+  Report("ExportTo", items, bytes, [&]() {
+    auto result = source->ExportTo(exportPath);
+    Check(result.first && result.second == items, "ExportTo");
+  });
+
+  Report("ImportFrom", items, bytes, [&]() {
+    auto result = target->ImportFrom(exportPath);
+    Check(result.first && result.second == items, "ImportFrom");
+  });
+
+  target->Clear();
+
+  Report("ImportFrom (keys)", items, bytes, [&]() {
+    auto result = target->ImportFrom(exportPath, true);
+    Check(result.first && result.second == items, "ImportFrom (keys)");
+  });
+
+  Report("PopFront", items, bytes, [&]() {
+    for (int i = 0; i < items; i++)
+      source->PopFront();
+  });
+
+  target->Clear();
+  remove(exportPath.c_str());
+
+  const int producers = 4;
+  auto striped = StripedPersistentList::Get(spDB, "bench_striped", producers);
+  striped->Clear();
+
+  Report("Striped PushBack (x4)", items, bytes, [&]() {
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+      threads.push_back(std::thread([&]() {
+        for (int i = 0; i < items / producers; i++)
+          striped->PushBack(value);
+      }));
+    }
+    for (auto &t : threads)
+      t.join();
+  });
+
+  Report("Striped PopFront", items, bytes, [&]() {
+    while (striped->PopFront())
+      ;
+  });
+
+  // the same list in process and through a server in this process
+  const std::string socketPath = "./benchdb.sock";
+  const int batch = 100;
+  ListServer server(spDB, socketPath);
+  Check(server.Start(), "starting the list server on " + socketPath);
+  auto remote =
+      RemotePersistentList::Get(ListClient::Connect(socketPath), "bench_source");
+
+  Report("Remote PushBack", items, bytes, [&]() {
+    for (int i = 0; i < items; i++)
+      remote->PushBack(value);
+  });
+
+  Report("Remote PopFront", items, bytes, [&]() {
+    for (int i = 0; i < items; i++)
+      remote->PopFront();
+  });
+
+  Report("Remote PushBack (pipe)", items, bytes, [&]() {
+    for (int i = 0; i < items; i++) {
+      remote->PushBackAsync(value);
+      if (i % batch == batch - 1)
+        remote->Sync();
+    }
+    remote->Sync();
+  });
+
+  Report("Remote PopFront (batch)", items, bytes, [&]() {
+    while (!remote->PopFront(batch).empty())
+      ;
+  });
+
+  Report("Remote PushBack (batch)", items, bytes, [&]() {
+    std::vector<std::string> values(batch, value);
+    for (int i = 0; i < items; i += batch)
+      remote->PushBack(values);
+  });
+
+  remote->Clear();
+  server.Stop();
+
+  auto memory = PersistentList::Get(MemoryDB::Open(), "bench_memory");
+
+  Report("Memory PushBack", items, bytes, [&]() {
+    for (int i = 0; i < items; i++)
+      memory->PushBack(value);
+  });
+
+  Report("Memory PopFront", items, bytes, [&]() {
+    for (int i = 0; i < items; i++)
+      memory->PopFront();
+  });
+
+  auto buffered = BufferedPersistentList::Get(spDB, "bench_buffered");
+  buffered->Clear();
+
+  Report("Buffered PushBack", items, bytes, [&]() {
+    for (int i = 0; i < items; i++)
+      buffered->PushBack(value);
+    buffered->Flush();
+  });
+
+  Report("Buffered PopFront", items, bytes, [&]() {
+    for (int i = 0; i < items; i++)
+      buffered->PopFront();
+  });
+
+  Report("Buffered Push+Pop", items, bytes, [&]() {
+    for (int i = 0; i < items; i++) {
+      buffered->PushBack(value);
+      buffered->PopFront();
+    }
+    buffered->Flush();
+  });
+  return 0;
+}
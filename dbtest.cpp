@@ -1,13 +1,33 @@
 #include "leveldb/db.h"
+#include "leveldb/write_batch.h"
+#include "AllocationCounter.h"
+#include "BufferedPersistentList.h"
+#include "DelayQueue.h"
+#include "ListClient.h"
+#include "ListCoding.h"
+#include "ListProtocol.h"
+#include "ListServer.h"
+#include "MemoryDB.h"
 #include "PersistentList.h"
 #include "PersistentListIterator.h"
+#include "PersistentListScanner.h"
+#include "SortedPersistentList.h"
+#include "StripedPersistentList.h"
+#include "StripedPersistentListIterator.h"
+#include "TypedPersistentList.h"
 #include "gtest/gtest.h"
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <stdio.h>
 #include <string.h>
+#include <thread>
 #include <utility>
+#include <vector>
 
 class PersistentListTest : public ::testing::Test {
 protected:
@@ -371,6 +391,1381 @@ TEST_F(PersistentListTest, CheckMidKeyAPI_7) {
   EXPECT_EQ(key, "pl/"+ id +"/NNNNNNNN8");
 }
 
+TEST_F(PersistentListTest, CheckMidKeyAPI_8) {
+  using namespace std;
+
+  auto pl = PersistentList::Get(spDB, "mylist");
+
+  string id = pl->Id();
+  string key = pl->MidKey("pl/" + id +"/NNNNNNNN", "pl/"+ id +"/NNNNNNNN#");
+  EXPECT_EQ(key, "pl/"+ id +"/NNNNNNNN\"N");
+}
+
+
+TEST_F(PersistentListTest, CheckScannerCount) {
+  using namespace std;
+
+  const int max_range = 1000;
+  auto pl = PersistentList::Get(spDB, "mylist");
+
+  pl->Clear();
+
+  for (int i = 0; i < max_range; i++) {
+    pl->PushBack(to_string(i));
+  }
+
+  // middle keys are longer than the fixed width ones
+  auto iter =
+      std::unique_ptr<PersistentListIterator>(new PersistentListIterator(pl));
+  iter->SeekFront();
+  for (int i = 0; i < 10 && iter->Next(); i++) {
+    pl->InsertAt(iter.get(), "inserted");
+  }
+
+  for (int partitions = 1; partitions <= 8; partitions++) {
+    PersistentListScanner scanner(pl, partitions, 4);
+    EXPECT_EQ(scanner.PartitionKeys().size(), partitions + 1);
+    EXPECT_EQ(scanner.Count(), max_range + 10);
+  }
+
+  pl->Clear();
+  PersistentListScanner scanner(pl, 4);
+  EXPECT_EQ(scanner.Count(), 0);
+}
+
+TEST_F(PersistentListTest, CheckScannerScan) {
+  using namespace std;
+
+  const int max_range = 1000;
+  auto pl = PersistentList::Get(spDB, "mylist");
+
+  pl->Clear();
+
+  for (int i = 0; i < max_range; i++) {
+    pl->PushBack(to_string(i));
+  }
+
+  PersistentListScanner scanner(pl, 6, 3);
+  vector<string> lastKeys(scanner.Partitions());
+  vector<int> seen(max_range, 0);
+  mutex seenMutex;
+
+  scanner.Scan([&](int partition, const leveldb::Slice &key,
+                   const leveldb::Slice &value) {
+    // each partition is scanned in key order
+    EXPECT_LT(lastKeys[partition], key.ToString());
+    lastKeys[partition] = key.ToString();
+    lock_guard<mutex> lock(seenMutex);
+    seen[stoi(value.ToString())]++;
+  });
+
+  for (int i = 0; i < max_range; i++) {
+    EXPECT_EQ(seen[i], 1);
+  }
+}
+
+TEST_F(PersistentListTest, CheckScannerPop) {
+  using namespace std;
+
+  const int max_range = 3000;
+  auto pl = PersistentList::Get(spDB, "mylist");
+
+  pl->Clear();
+
+  for (int i = 0; i < max_range; i++) {
+    pl->PushBack(to_string(i % 3));
+  }
+
+  PersistentListScanner scanner(pl, 4);
+  EXPECT_EQ(scanner.PopValue("0"), max_range / 3);
+  EXPECT_EQ(pl->Size(), max_range - max_range / 3);
+
+  EXPECT_EQ(scanner.PopIf([](const leveldb::Slice &value) {
+    return value.ToString() == "1";
+  }), max_range / 3);
+  EXPECT_EQ(pl->Size(), max_range / 3);
+
+  auto front = pl->Front();
+  ASSERT_TRUE(front.first);
+  EXPECT_EQ(front.second, "2");
+}
+
+TEST_F(PersistentListTest, CheckInsertAtLongKeys) {
+  using namespace std;
+
+  auto pl = PersistentList::Get(spDB, "longkeys");
+  pl->Clear();
+  pl->PushBack("first");
+  pl->PushBack("last");
+
+  // always right after the first item, each key longer or as long as the
+  // one before; far past the digits a 64-bit number holds
+  const size_t prefixLen = ("pl/" + pl->Id() + "/").length();
+  vector<string> inserted;
+  string key;
+  while (key.length() < prefixLen + 32) {
+    auto iter =
+        unique_ptr<PersistentListIterator>(new PersistentListIterator(pl));
+    iter->SeekFront();
+    ASSERT_TRUE(iter->Next());
+    ASSERT_TRUE(iter->Next());
+    inserted.push_back(to_string(inserted.size()));
+    key = pl->InsertAt(iter.get(), inserted.back());
+  }
+  EXPECT_GT(key.length(), prefixLen + 16);
+
+  auto iter =
+      unique_ptr<PersistentListIterator>(new PersistentListIterator(pl));
+  iter->SeekFront();
+  ASSERT_TRUE(iter->Next());
+  EXPECT_EQ(iter->Value(), "first");
+  for (size_t i = inserted.size(); i-- > 0;) {
+    ASSERT_TRUE(iter->Next());
+    EXPECT_EQ(iter->Value(), inserted[i]);
+  }
+  ASSERT_TRUE(iter->Next());
+  EXPECT_EQ(iter->Value(), "last");
+  EXPECT_FALSE(iter->Next());
+  EXPECT_EQ(pl->Size(), (int)inserted.size() + 2);
+}
+
+TEST_F(PersistentListTest, CheckSortedInsert) {
+  using namespace std;
+
+  const int max_range = 1000;
+  auto numeric = [](const string &a, const string &b) {
+    return stoi(a) < stoi(b);
+  };
+  auto spl = SortedPersistentList::Get(spDB, "mysortedlist", numeric);
+
+  spl->Clear();
+
+  // a fixed permutation of [0, max_range)
+  for (int i = 0; i < max_range; i++) {
+    spl->InsertSorted(to_string((i * 7919) % max_range));
+  }
+
+  ASSERT_EQ(spl->Size(), max_range);
+
+  auto iter = std::unique_ptr<PersistentListIterator>(
+      new PersistentListIterator(spl->List()));
+  int count = 0;
+  iter->SeekFront();
+  while (iter->Next()) {
+    EXPECT_EQ(to_string(count), iter->Value());
+    count++;
+  }
+  EXPECT_EQ(count, max_range);
+
+  // the index is persisted, a reopened list keeps inserting in order
+  spl = SortedPersistentList::Get(spDB, "mysortedlist", numeric);
+  spl->InsertSorted("500");
+  spl->InsertSorted("-1");
+  spl->InsertSorted(to_string(max_range));
+
+  count = -1;
+  iter = std::unique_ptr<PersistentListIterator>(
+      new PersistentListIterator(spl->List()));
+  iter->SeekFront();
+  while (iter->Next()) {
+    int value = stoi(iter->Value());
+    EXPECT_TRUE(value == count || value == count + 1);
+    count = value;
+  }
+  EXPECT_EQ(count, max_range);
+  EXPECT_EQ(spl->Size(), max_range + 3);
+}
+
+TEST_F(PersistentListTest, CheckSortedBounds) {
+  using namespace std;
+
+  auto spl = SortedPersistentList::Get(spDB, "mysortedlist");
+
+  spl->Clear();
+
+  for (int i = 0; i < 300; i++) {
+    // "000", "002", ... each twice
+    char data[8];
+    snprintf(data, sizeof(data), "%03d", (i % 150) * 2);
+    spl->InsertSorted(data);
+  }
+
+  auto iter = std::unique_ptr<PersistentListIterator>(
+      new PersistentListIterator(spl->List()));
+
+  ASSERT_TRUE(spl->LowerBound(iter.get(), "100"));
+  EXPECT_EQ(iter->Value(), "100");
+  ASSERT_TRUE(iter->Next());
+  EXPECT_EQ(iter->Value(), "100");
+  ASSERT_TRUE(iter->Next());
+  EXPECT_EQ(iter->Value(), "102");
+
+  ASSERT_TRUE(spl->UpperBound(iter.get(), "100"));
+  EXPECT_EQ(iter->Value(), "102");
+  ASSERT_TRUE(iter->Prev());
+  EXPECT_EQ(iter->Value(), "100");
+
+  ASSERT_TRUE(spl->LowerBound(iter.get(), "101"));
+  EXPECT_EQ(iter->Value(), "102");
+
+  ASSERT_TRUE(spl->LowerBound(iter.get(), ""));
+  EXPECT_EQ(iter->Value(), "000");
+
+  EXPECT_FALSE(spl->UpperBound(iter.get(), "298"));
+  EXPECT_FALSE(spl->LowerBound(iter.get(), "299"));
+}
+
+TEST_F(PersistentListTest, CheckSortedPop) {
+  using namespace std;
+
+  // order by the leading number, ignoring the payload
+  auto spl = SortedPersistentList::Get(
+      spDB, "mysortedlist", SortedPersistentList::ByKey([](const string &value) {
+        return value.substr(0, 3);
+      }));
+
+  spl->Clear();
+  EXPECT_FALSE(spl->PopMin().first);
+  EXPECT_FALSE(spl->PopMax().first);
+
+  for (int i = 0; i < 500; i++) {
+    char data[8];
+    snprintf(data, sizeof(data), "%03d", (i * 13) % 500);
+    spl->InsertSorted(string(data) + "|" + to_string(i));
+  }
+
+  for (int i = 0; i < 250; i++) {
+    char low[8], high[8];
+    snprintf(low, sizeof(low), "%03d", i);
+    snprintf(high, sizeof(high), "%03d", 499 - i);
+    EXPECT_EQ(spl->Min().second.substr(0, 3), low);
+    auto minItem = spl->PopMin();
+    ASSERT_TRUE(minItem.first);
+    EXPECT_EQ(minItem.second.substr(0, 3), low);
+    auto maxItem = spl->PopMax();
+    ASSERT_TRUE(maxItem.first);
+    EXPECT_EQ(maxItem.second.substr(0, 3), high);
+
+    // refill the popped range, reusing the freed keys
+    if (i % 50 == 0) {
+      spl->InsertSorted(string(low) + "|again");
+      EXPECT_EQ(spl->PopMin().second, string(low) + "|again");
+    }
+  }
+  EXPECT_EQ(spl->Size(), 0);
+}
+
+TEST_F(PersistentListTest, CheckExportImport) {
+  using namespace std;
+
+  const int max_range = 5000;
+  const string path = "./db.export";
+  auto pl = PersistentList::Get(spDB, "mylist");
+  auto copy = PersistentList::Get(spDB, "mylistcopy");
+
+  pl->Clear();
+  copy->Clear();
+
+  for (int i = 0; i < max_range; i++) {
+    pl->PushBack(string(i % 300, (char)i) + to_string(i));
+  }
+  pl->PushBack("");
+
+  // the export reads the snapshot, not the later changes
+  const leveldb::Snapshot *snapshot = spDB->GetSnapshot();
+  pl->PushFront("after snapshot");
+
+  auto exported = pl->ExportTo(path, snapshot);
+  spDB->ReleaseSnapshot(snapshot);
+  ASSERT_TRUE(exported.first);
+  EXPECT_EQ(exported.second, max_range + 1);
+
+  copy->PushBack("existing");
+  auto imported = copy->ImportFrom(path);
+  ASSERT_TRUE(imported.first);
+  EXPECT_EQ(imported.second, max_range + 1);
+  ASSERT_EQ(copy->Size(), max_range + 2);
+
+  EXPECT_EQ(copy->Front().second, "existing");
+  EXPECT_EQ(copy->Back().second, "");
+  copy->PopFront();
+  for (int i = 0; i < max_range; i++) {
+    EXPECT_EQ(copy->Front().second, string(i % 300, (char)i) + to_string(i));
+    copy->PopFront();
+  }
+
+  // preserved keys line up with the source list
+  copy->Clear();
+  pl->PopFront();
+  imported = copy->ImportFrom(path, true);
+  ASSERT_TRUE(imported.first);
+
+  auto srcIter =
+      std::unique_ptr<PersistentListIterator>(new PersistentListIterator(pl));
+  auto dstIter = std::unique_ptr<PersistentListIterator>(
+      new PersistentListIterator(copy));
+  srcIter->SeekFront();
+  dstIter->SeekFront();
+  while (srcIter->Next()) {
+    ASSERT_TRUE(dstIter->Next());
+    EXPECT_EQ(srcIter->Key().substr(srcIter->Key().find('/', 3)),
+              dstIter->Key().substr(dstIter->Key().find('/', 3)));
+    EXPECT_EQ(srcIter->Value(), dstIter->Value());
+  }
+  EXPECT_FALSE(dstIter->Next());
+
+  remove(path.c_str());
+}
+
+TEST_F(PersistentListTest, CheckImportCorrupt) {
+  using namespace std;
+
+  const string path = "./db.export";
+  auto pl = PersistentList::Get(spDB, "mylist");
+  auto copy = PersistentList::Get(spDB, "mylistcopy");
+
+  pl->Clear();
+  copy->Clear();
+
+  for (int i = 0; i < 100; i++) {
+    pl->PushBack(to_string(i));
+  }
+  ASSERT_TRUE(pl->ExportTo(path).first);
+
+  // flip a byte of the data block
+  FILE *file = fopen(path.c_str(), "r+b");
+  ASSERT_TRUE(file != nullptr);
+  fseek(file, 20, SEEK_SET);
+  int c = fgetc(file);
+  fseek(file, 20, SEEK_SET);
+  fputc(c ^ 0xFF, file);
+  fclose(file);
+
+  auto imported = copy->ImportFrom(path);
+  EXPECT_FALSE(imported.first);
+  EXPECT_EQ(copy->Size(), 0);
+
+  EXPECT_FALSE(copy->ImportFrom("./db.missing").first);
+  remove(path.c_str());
+}
+
+TEST_F(PersistentListTest, CheckStripedOrder) {
+  using namespace std;
+
+  const int max_range = 500;
+  auto spl = StripedPersistentList::Get(spDB, "mystripedlist", 4);
+  ASSERT_EQ(spl->Stripes(), 4);
+
+  spl->Clear();
+  EXPECT_FALSE(spl->Front().first);
+  EXPECT_FALSE(spl->PopFront());
+
+  for (int i = 0; i < max_range; i++) {
+    spl->PushBack(to_string(i));
+  }
+  ASSERT_EQ(spl->Size(), max_range);
+
+  auto iter = std::unique_ptr<StripedPersistentListIterator>(
+      new StripedPersistentListIterator(spl));
+  iter->SeekFront();
+  int count = 0;
+  uint64_t lastSequence = 0;
+  while (iter->Next()) {
+    EXPECT_EQ(iter->Value(), to_string(count));
+    if (count > 0) {
+      EXPECT_LT(lastSequence, iter->Sequence());
+    }
+    lastSequence = iter->Sequence();
+    count++;
+  }
+  EXPECT_EQ(count, max_range);
+
+  // a reopened list continues the sequence and keeps the stripe count
+  spl = StripedPersistentList::Get(spDB, "mystripedlist", 8);
+  ASSERT_EQ(spl->Stripes(), 4);
+  EXPECT_GT(spl->PushBack(to_string(max_range)), lastSequence);
+
+  for (int i = 0; i <= max_range; i++) {
+    EXPECT_EQ(spl->Front().second, to_string(i));
+    string value;
+    ASSERT_TRUE(spl->PopFront(&value));
+    EXPECT_EQ(value, to_string(i));
+  }
+  EXPECT_EQ(spl->Size(), 0);
+}
+
+TEST_F(PersistentListTest, CheckStripedProducers) {
+  using namespace std;
+
+  const int producers = 4;
+  const int max_range = 250;
+  auto spl = StripedPersistentList::Get(spDB, "mystripedlist", 4);
+
+  spl->Clear();
+
+  vector<thread> threads;
+  for (int p = 0; p < producers; p++) {
+    threads.push_back(thread([spl, p, max_range]() {
+      for (int i = 0; i < max_range; i++) {
+        spl->PushBack(to_string(p) + ":" + to_string(i));
+      }
+    }));
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  ASSERT_EQ(spl->Size(), producers * max_range);
+
+  // each producer's items come out in its push order
+  vector<int> next(producers, 0);
+  string value;
+  while (spl->PopFront(&value)) {
+    int p = stoi(value.substr(0, value.find(':')));
+    int i = stoi(value.substr(value.find(':') + 1));
+    EXPECT_EQ(i, next[p]);
+    next[p] = i + 1;
+  }
+  for (int p = 0; p < producers; p++) {
+    EXPECT_EQ(next[p], max_range);
+  }
+}
+
+TEST_F(PersistentListTest, CheckFollowIterAPI) {
+  using namespace std;
+
+  const int max_range = 100;
+  auto pl = PersistentList::Get(spDB, "mylist");
+
+  pl->Clear();
+  pl->PushBack("old");
+
+  auto iter =
+      std::unique_ptr<PersistentListIterator>(new PersistentListIterator(pl));
+  iter->SeekBack();
+  EXPECT_FALSE(iter->WaitNext(10));
+  EXPECT_FALSE(iter->Valid());
+
+  // the producer works through its own instance of the list
+  thread producer([this, max_range]() {
+    auto producerList = PersistentList::Get(spDB, "mylist");
+    for (int i = 0; i < max_range; i++) {
+      producerList->PushBack(to_string(i));
+      if (i % 10 == 0) {
+        this_thread::sleep_for(chrono::milliseconds(2));
+      }
+    }
+  });
+
+  for (int i = 0; i < max_range; i++) {
+    ASSERT_TRUE(iter->WaitNext(5000));
+    EXPECT_EQ(iter->Value(), to_string(i));
+  }
+  producer.join();
+
+  EXPECT_FALSE(iter->WaitNext(10));
+
+  // consumers at the front do not disturb the follower
+  pl->PopFront();
+  pl->PushBack("next");
+  ASSERT_TRUE(iter->WaitNext(10));
+  EXPECT_EQ(iter->Value(), "next");
+  ASSERT_TRUE(iter->Prev());
+  EXPECT_EQ(iter->Value(), to_string(max_range - 1));
+}
+
+TEST_F(PersistentListTest, CheckDelayQueue) {
+  using namespace std;
+
+  auto dq = DelayQueue::Get(spDB, "mydelayqueue");
+
+  dq->List()->Clear();
+  EXPECT_EQ(dq->NextDueTime(), DelayQueue::NO_DUE_TIME);
+
+  const uint64_t now = DelayQueue::Now();
+
+  // pushed out of order, some due at the same time
+  for (int i = 9; i >= 0; i--) {
+    dq->Push("late" + to_string(i), now + 1000 * (i + 1));
+    dq->Push("due" + to_string(i), now - 1000 * (10 - i));
+  }
+  dq->Push("now1", now);
+  dq->Push("now2", now);
+
+  EXPECT_EQ(dq->Size(), 22);
+  EXPECT_EQ(dq->NextDueTime(), now - 10000);
+
+  uint64_t nextDueTime = 0;
+  auto values = dq->PopDue(now, 4, &nextDueTime);
+  ASSERT_EQ(values.size(), 4);
+  for (int i = 0; i < 4; i++) {
+    EXPECT_EQ(values[i], "due" + to_string(i));
+  }
+  EXPECT_EQ(nextDueTime, now - 6000);
+
+  values = dq->PopDue(now, 100, &nextDueTime);
+  ASSERT_EQ(values.size(), 8);
+  EXPECT_EQ(values[5], "due9");
+  EXPECT_EQ(values[6], "now1");
+  EXPECT_EQ(values[7], "now2");
+  EXPECT_EQ(nextDueTime, now + 1000);
+
+  // nothing is due until the hint
+  EXPECT_TRUE(dq->PopDue(nextDueTime - 1, 100).empty());
+
+  values = dq->PopDue(now + 5000, 100, &nextDueTime);
+  ASSERT_EQ(values.size(), 5);
+  EXPECT_EQ(values[0], "late0");
+  EXPECT_EQ(nextDueTime, now + 6000);
+
+  // a reopened queue keeps the order of equal due times
+  dq = DelayQueue::Get(spDB, "mydelayqueue");
+  dq->Push("late4b", now + 5000);
+  dq->Push("late5b", now + 6000);
+
+  values = dq->PopDue(DelayQueue::NO_DUE_TIME, 100, &nextDueTime);
+  ASSERT_EQ(values.size(), 7);
+  EXPECT_EQ(values[0], "late4b");
+  EXPECT_EQ(values[1], "late5");
+  EXPECT_EQ(values[2], "late5b");
+  EXPECT_EQ(nextDueTime, DelayQueue::NO_DUE_TIME);
+  EXPECT_EQ(dq->Size(), 0);
+}
+
+namespace {
+
+struct Point {
+  int x;
+  double y;
+};
+
+// A user codec: "key=value" pairs
+struct KeyValueCodec {
+  static leveldb::Slice Encode(const std::pair<std::string, std::string> &kv,
+                               std::string *buffer) {
+    buffer->assign(kv.first);
+    buffer->push_back('=');
+    buffer->append(kv.second);
+    return leveldb::Slice(*buffer);
+  }
+
+  static bool Decode(const leveldb::Slice &data,
+                     std::pair<std::string, std::string> *kv) {
+    std::string text = data.ToString();
+    size_t pos = text.find('=');
+    if (pos == std::string::npos)
+      return false;
+    kv->first = text.substr(0, pos);
+    kv->second = text.substr(pos + 1);
+    return true;
+  }
+};
+
+} // namespace
+
+TEST_F(PersistentListTest, CheckTypedPODList) {
+  using namespace std;
+
+  const int max_range = 256;
+  auto tpl = TypedPersistentList<Point>::Get(spDB, "mytypedlist");
+
+  tpl->Clear();
+  EXPECT_FALSE(tpl->Front().first);
+
+  for (int i = 0; i < max_range; i++) {
+    tpl->PushBack(Point{i, i / 2.0});
+  }
+  ASSERT_EQ(tpl->Size(), max_range);
+
+  TypedPersistentListIterator<Point> iter(tpl);
+  iter.SeekFront();
+  int count = 0;
+  while (iter.Next()) {
+    Point p;
+    ASSERT_TRUE(iter.Value(&p));
+    EXPECT_EQ(p.x, count);
+    EXPECT_EQ(p.y, count / 2.0);
+    count++;
+  }
+  EXPECT_EQ(count, max_range);
+
+  iter.SeekFront();
+  ASSERT_TRUE(iter.Next());
+  tpl->InsertAt(&iter, Point{-1, -1});
+  EXPECT_EQ(tpl->Front().second.x, -1);
+  EXPECT_EQ(tpl->Back().second.x, max_range - 1);
+
+  // a value of the wrong size does not decode
+  tpl->List()->PushBack("junk");
+  EXPECT_FALSE(tpl->Back().first);
+  tpl->PopBack();
+  EXPECT_TRUE(tpl->Back().first);
+}
+
+TEST_F(PersistentListTest, CheckTypedCodecs) {
+  using namespace std;
+
+  auto varints =
+      TypedPersistentList<int64_t, VarintCodec<int64_t>>::Get(spDB,
+                                                              "mytypedlist");
+  varints->Clear();
+
+  vector<int64_t> values = {0, 1, -1, 63, -64, 64, 300, -300, INT64_MAX,
+                            INT64_MIN};
+  for (int64_t value : values) {
+    varints->PushBack(value);
+  }
+
+  // small values take a single byte
+  PersistentListIterator raw(varints->List());
+  raw.SeekFront();
+  ASSERT_TRUE(raw.Next());
+  EXPECT_EQ(raw.ValueSlice().size(), 1);
+
+  for (int64_t value : values) {
+    auto front = varints->Front();
+    ASSERT_TRUE(front.first);
+    EXPECT_EQ(front.second, value);
+    varints->PopFront();
+  }
+
+  auto counts =
+      TypedPersistentList<uint8_t, VarintCodec<uint8_t>>::Get(spDB,
+                                                              "mytypedlist");
+  counts->PushBack(255);
+  EXPECT_EQ(counts->Front().second, 255);
+  counts->Clear();
+
+  auto strings = TypedPersistentList<string>::Get(spDB, "mytypedlist");
+  strings->PushBack(string("with\0nul", 8));
+  EXPECT_EQ(strings->Front().second, string("with\0nul", 8));
+  strings->Clear();
+
+  typedef pair<string, string> KeyValue;
+  auto kvs =
+      TypedPersistentList<KeyValue, KeyValueCodec>::Get(spDB, "mytypedlist");
+  kvs->PushBack(KeyValue("a", "1"));
+  kvs->PushFront(KeyValue("b", "2"));
+
+  TypedPersistentListIterator<KeyValue, KeyValueCodec> iter(kvs);
+  iter.SeekBack();
+  ASSERT_TRUE(iter.Prev());
+  EXPECT_EQ(iter.Value(), make_pair(true, KeyValue("a", "1")));
+  ASSERT_TRUE(iter.Prev());
+  EXPECT_EQ(iter.Value(), make_pair(true, KeyValue("b", "2")));
+  EXPECT_FALSE(iter.Prev());
+  kvs->Clear();
+
+  // a value that does not decode is not taken for a default value
+  auto numbers = TypedPersistentList<int32_t>::Get(spDB, "mytypedlist");
+  numbers->List()->PushBack("xy");
+  TypedPersistentListIterator<int32_t> numIter(numbers);
+  numIter.SeekFront();
+  ASSERT_TRUE(numIter.Next());
+  EXPECT_FALSE(numIter.Value().first);
+  int32_t number = 0;
+  EXPECT_FALSE(numIter.Value(&number));
+  EXPECT_FALSE(numbers->Front().first);
+  numbers->Clear();
+}
+
+namespace {
+
+// The database calls are excluded from the allocation count
+class UncountedIterator : public leveldb::Iterator {
+public:
+  explicit UncountedIterator(leveldb::Iterator *iter) : mIter(iter) {}
+  ~UncountedIterator() override {
+    PauseAllocationCount pause;
+    delete mIter;
+  }
+
+  bool Valid() const override {
+    PauseAllocationCount pause;
+    return mIter->Valid();
+  }
+  void SeekToFirst() override {
+    PauseAllocationCount pause;
+    mIter->SeekToFirst();
+  }
+  void SeekToLast() override {
+    PauseAllocationCount pause;
+    mIter->SeekToLast();
+  }
+  void Seek(const leveldb::Slice &target) override {
+    PauseAllocationCount pause;
+    mIter->Seek(target);
+  }
+  void Next() override {
+    PauseAllocationCount pause;
+    mIter->Next();
+  }
+  void Prev() override {
+    PauseAllocationCount pause;
+    mIter->Prev();
+  }
+  leveldb::Slice key() const override {
+    PauseAllocationCount pause;
+    return mIter->key();
+  }
+  leveldb::Slice value() const override {
+    PauseAllocationCount pause;
+    return mIter->value();
+  }
+  leveldb::Status status() const override {
+    PauseAllocationCount pause;
+    return mIter->status();
+  }
+
+private:
+  leveldb::Iterator *mIter;
+};
+
+// Forwards to a database without counting its allocations
+class UncountedDB : public leveldb::DB {
+public:
+  explicit UncountedDB(std::shared_ptr<leveldb::DB> db) : mDB(db) {}
+
+  leveldb::Status Put(const leveldb::WriteOptions &options,
+                      const leveldb::Slice &key,
+                      const leveldb::Slice &value) override {
+    PauseAllocationCount pause;
+    return mDB->Put(options, key, value);
+  }
+  leveldb::Status Delete(const leveldb::WriteOptions &options,
+                         const leveldb::Slice &key) override {
+    PauseAllocationCount pause;
+    return mDB->Delete(options, key);
+  }
+  leveldb::Status Write(const leveldb::WriteOptions &options,
+                        leveldb::WriteBatch *updates) override {
+    PauseAllocationCount pause;
+    return mDB->Write(options, updates);
+  }
+  leveldb::Status Get(const leveldb::ReadOptions &options,
+                      const leveldb::Slice &key, std::string *value) override {
+    PauseAllocationCount pause;
+    return mDB->Get(options, key, value);
+  }
+  leveldb::Iterator *NewIterator(const leveldb::ReadOptions &options) override {
+    PauseAllocationCount pause;
+    return new UncountedIterator(mDB->NewIterator(options));
+  }
+  const leveldb::Snapshot *GetSnapshot() override {
+    PauseAllocationCount pause;
+    return mDB->GetSnapshot();
+  }
+  void ReleaseSnapshot(const leveldb::Snapshot *snapshot) override {
+    PauseAllocationCount pause;
+    mDB->ReleaseSnapshot(snapshot);
+  }
+  bool GetProperty(const leveldb::Slice &property,
+                   std::string *value) override {
+    PauseAllocationCount pause;
+    return mDB->GetProperty(property, value);
+  }
+  void GetApproximateSizes(const leveldb::Range *range, int n,
+                           uint64_t *sizes) override {
+    PauseAllocationCount pause;
+    mDB->GetApproximateSizes(range, n, sizes);
+  }
+  void CompactRange(const leveldb::Slice *begin,
+                    const leveldb::Slice *end) override {
+    PauseAllocationCount pause;
+    mDB->CompactRange(begin, end);
+  }
+
+private:
+  std::shared_ptr<leveldb::DB> mDB;
+};
+
+} // namespace
+
+// The returned keys fit the small string storage only while the list id
+// has at most 3 digits ("pl/" + id + "/" + 8 symbols <= 15 chars); longer
+// ones allocate the returned key.
+TEST_F(PersistentListTest, CheckHotPathAllocations) {
+  using namespace std;
+
+  const int max_range = 256;
+  // a list id too long for the small string storage of the keys
+  auto mdb = MemoryDB::Open();
+  mdb->Put(leveldb::WriteOptions(), "pl/next_id", "1234567");
+  auto udb = std::make_shared<UncountedDB>(mdb);
+  auto pl = PersistentList::Get(udb, "mylist");
+  ASSERT_EQ(pl->Id(), "1234567");
+
+  const string value(100, 'x');
+  string key, front;
+  front.reserve(value.size());
+  pl->PushBack(value, &key);
+  pl->PopBack();
+
+  gAllocations = 0;
+  gCountAllocations = true;
+
+  for (int i = 0; i < max_range; i++) {
+    pl->PushBack(value, &key);
+    pl->PushFront(value, &key);
+  }
+  for (int i = 0; i < max_range; i++) {
+    pl->Front(&front);
+    pl->Back(&front);
+    pl->PopFront();
+    pl->PopBack();
+  }
+
+  gCountAllocations = false;
+  EXPECT_EQ(gAllocations, 0);
+  EXPECT_EQ(pl->Size(), 0);
+}
+
+TEST_F(PersistentListTest, CheckListServer) {
+  using namespace std;
+
+  const int max_range = 100;
+  ListServer server(spDB, "./db.sock");
+  ASSERT_TRUE(server.Start());
+
+  auto client = ListClient::Connect("./db.sock");
+  ASSERT_TRUE(client != nullptr);
+  auto rl = RemotePersistentList::Get(client, "remotelist");
+  auto pl = PersistentList::Get(spDB, "remotelist");
+
+  rl->Clear();
+  EXPECT_EQ(rl->Size(), 0);
+  EXPECT_FALSE(rl->Front().first);
+  EXPECT_FALSE(rl->PopFront());
+
+  auto key = rl->PushBack("b");
+  EXPECT_FALSE(key.empty());
+  rl->PushFront("a");
+  rl->PushBack("c");
+  EXPECT_EQ(rl->Size(), 3);
+  EXPECT_EQ(pl->Size(), 3);
+  EXPECT_EQ(rl->Front().second, "a");
+  EXPECT_EQ(rl->Back().second, "c");
+
+  auto items = rl->Scan("", 2);
+  ASSERT_EQ(items.size(), 2);
+  EXPECT_EQ(items[0].second, "a");
+  EXPECT_EQ(items[1].first, key);
+  items = rl->Scan(key, 10);
+  ASSERT_EQ(items.size(), 1);
+  EXPECT_EQ(items[0].second, "c");
+
+  EXPECT_TRUE(rl->PopKey(key));
+  EXPECT_TRUE(rl->PopValue("c"));
+  string value;
+  EXPECT_TRUE(rl->PopBack(&value));
+  EXPECT_EQ(value, "a");
+  EXPECT_EQ(rl->Size(), 0);
+
+  // pipelined and batched pushes keep their order
+  for (int i = 0; i < max_range; i++)
+    rl->PushBackAsync(to_string(i));
+  EXPECT_EQ(rl->Sync(), max_range);
+
+  vector<string> values;
+  for (int i = max_range; i < 2 * max_range; i++)
+    values.push_back(to_string(i));
+  EXPECT_EQ(rl->PushBack(values).size(), max_range);
+  EXPECT_EQ(rl->Size(), 2 * max_range);
+
+  // a sync call waits for the pending async ones
+  rl->PushBackAsync("last");
+  EXPECT_EQ(rl->Back().second, "last");
+  EXPECT_TRUE(rl->PopBack());
+
+  values = rl->PopFront(2 * max_range + 10);
+  ASSERT_EQ(values.size(), 2 * max_range);
+  for (int i = 0; i < 2 * max_range; i++)
+    EXPECT_EQ(values[i], to_string(i));
+
+  // a blocking pop is woken by a push from another connection
+  EXPECT_FALSE(rl->WaitPopFront(50).first);
+  thread producer([] {
+    this_thread::sleep_for(chrono::milliseconds(50));
+    auto client = ListClient::Connect("./db.sock");
+    RemotePersistentList::Get(client, "remotelist")->PushBack("pushed");
+  });
+  auto popped = rl->WaitPopFront(5000);
+  producer.join();
+  EXPECT_TRUE(popped.first);
+  EXPECT_EQ(popped.second, "pushed");
+
+  server.Stop();
+  EXPECT_EQ(rl->Size(), 0);
+  EXPECT_FALSE(client->Connected());
+}
+
+TEST_F(PersistentListTest, CheckMemoryDB) {
+  using namespace std;
+
+  auto db = MemoryDB::Open();
+  string value, entries;
+
+  EXPECT_TRUE(db->Get(readOptions, "a", &value).IsNotFound());
+  db->Put(writeOptions, "b", "2");
+  db->Put(writeOptions, "a", "1");
+  db->Put(writeOptions, "c", "3");
+  EXPECT_TRUE(db->Get(readOptions, "a", &value).ok());
+  EXPECT_EQ(value, "1");
+
+  // iterators and snapshots read as of their creation
+  auto snapshot = db->GetSnapshot();
+  auto iter = unique_ptr<leveldb::Iterator>(db->NewIterator(readOptions));
+  db->Delete(writeOptions, "b");
+  db->Put(writeOptions, "a", "one");
+  db->Put(writeOptions, "d", "4");
+
+  string keys;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next())
+    keys += iter->key().ToString() + iter->value().ToString();
+  EXPECT_EQ(keys, "a1b2c3");
+
+  keys.clear();
+  for (iter->SeekToLast(); iter->Valid(); iter->Prev())
+    keys += iter->key().ToString();
+  EXPECT_EQ(keys, "cba");
+  iter.reset();
+
+  leveldb::ReadOptions snapshotOptions;
+  snapshotOptions.snapshot = snapshot;
+  EXPECT_TRUE(db->Get(snapshotOptions, "b", &value).ok());
+  EXPECT_EQ(value, "2");
+  EXPECT_TRUE(db->Get(readOptions, "b", &value).IsNotFound());
+  db->ReleaseSnapshot(snapshot);
+
+  iter.reset(db->NewIterator(readOptions));
+  iter->Seek("b");
+  ASSERT_TRUE(iter->Valid());
+  EXPECT_EQ(iter->key().ToString(), "c");
+  iter->Prev();
+  EXPECT_EQ(iter->value().ToString(), "one");
+  iter.reset();
+
+  // a batch is applied at once, its last write of a key wins
+  leveldb::WriteBatch batch;
+  batch.Put("e", "5");
+  batch.Delete("a");
+  batch.Put("c", "three");
+  batch.Delete("c");
+  batch.Put("c", "drei");
+  db->Write(writeOptions, &batch);
+  EXPECT_TRUE(db->Get(readOptions, "a", &value).IsNotFound());
+  EXPECT_TRUE(db->Get(readOptions, "c", &value).ok());
+  EXPECT_EQ(value, "drei");
+
+  uint64_t size;
+  leveldb::Range range("c", "e");
+  db->GetApproximateSizes(&range, 1, &size);
+  EXPECT_EQ(size, 7);
+
+  // deleted items are reclaimed once no reader needs them
+  EXPECT_TRUE(db->GetProperty("memorydb.num-entries", &entries));
+  EXPECT_EQ(entries, "3");
+  snapshot = db->GetSnapshot();
+  db->Delete(writeOptions, "c");
+  db->Delete(writeOptions, "d");
+  db->Delete(writeOptions, "e");
+  db->GetProperty("memorydb.num-entries", &entries);
+  EXPECT_EQ(entries, "3");
+  db->ReleaseSnapshot(snapshot);
+  db->GetProperty("memorydb.num-entries", &entries);
+  EXPECT_EQ(entries, "0");
+}
+
+TEST_F(PersistentListTest, CheckMemoryDBLists) {
+  using namespace std;
+
+  const int max_range = 1000;
+  auto db = MemoryDB::Open();
+  auto pl = PersistentList::Get(db, "memlist");
+
+  for (int i = 0; i < max_range; i++) {
+    pl->PushBack(to_string(i));
+    pl->PushFront(to_string(-i));
+  }
+  EXPECT_EQ(pl->Size(), 2 * max_range);
+  EXPECT_EQ(pl->Front().second, to_string(-(max_range - 1)));
+  EXPECT_EQ(pl->Back().second, to_string(max_range - 1));
+
+  PersistentListIterator iter(pl);
+  iter.SeekBack();
+  int count = 0;
+  while (iter.Prev())
+    count++;
+  EXPECT_EQ(count, 2 * max_range);
+
+  PersistentListScanner scanner(pl, 4);
+  EXPECT_EQ(scanner.Count(), 2 * max_range);
+
+  auto sorted = SortedPersistentList::Get(db, "memsorted");
+  for (int i = max_range - 1; i >= 0; i--)
+    sorted->InsertSorted(to_string(i % 10));
+  EXPECT_EQ(sorted->Min().second, "0");
+  EXPECT_EQ(sorted->Max().second, "9");
+
+  // a queue churning over the same keys does not grow the database
+  string entries;
+  for (int i = 0; i < 2 * max_range; i++)
+    pl->PopFront();
+  db->GetProperty("memorydb.num-entries", &entries);
+  auto before = entries;
+  for (int i = 0; i < max_range; i++) {
+    pl->PushBack(to_string(i));
+    pl->PopFront();
+  }
+  EXPECT_EQ(pl->Size(), 0);
+  db->GetProperty("memorydb.num-entries", &entries);
+  EXPECT_EQ(entries, before);
+
+  // nothing is shared with another in-memory store
+  EXPECT_EQ(PersistentList::Get(MemoryDB::Open(), "memsorted")->Size(), 0);
+}
+
+TEST_F(PersistentListTest, CheckBufferedList) {
+  using namespace std;
+
+  // no flush but the explicit ones
+  auto bl = BufferedPersistentList::Get(spDB, "bufferedlist", 1000, 3600000);
+  auto pl = bl->List();
+  bl->Clear();
+
+  for (int i = 0; i < 10; i++)
+    bl->PushBack(to_string(i));
+  for (int i = 1; i <= 5; i++)
+    bl->PushFront(to_string(-i));
+  EXPECT_EQ(bl->Size(), 15);
+  EXPECT_EQ(bl->Buffered(), 15);
+  EXPECT_EQ(pl->Size(), 0);
+  EXPECT_EQ(bl->Front().second, "-5");
+  EXPECT_EQ(bl->Back().second, "9");
+
+  // push/pop pairs never reach the database
+  string value;
+  EXPECT_TRUE(bl->PopFront(&value));
+  EXPECT_EQ(value, "-5");
+  EXPECT_TRUE(bl->PopFront());
+  EXPECT_EQ(bl->Buffered(), 13);
+
+  EXPECT_TRUE(bl->Flush());
+  EXPECT_EQ(bl->Buffered(), 0);
+  EXPECT_EQ(pl->Size(), 13);
+
+  vector<string> expected = {"-3", "-2", "-1"};
+  for (int i = 0; i < 10; i++)
+    expected.push_back(to_string(i));
+  PersistentListIterator iter(pl);
+  iter.SeekFront();
+  for (auto &e : expected) {
+    ASSERT_TRUE(iter.Next());
+    EXPECT_EQ(iter.Value(), e);
+  }
+
+  bl->PushBack("x");
+  EXPECT_TRUE(bl->PopBack(&value));
+  EXPECT_EQ(value, "x");
+  bl->PushFront("y");
+  EXPECT_TRUE(bl->PopFront(&value));
+  EXPECT_EQ(value, "y");
+  EXPECT_EQ(pl->Size(), 13);
+
+  // reads and pops reach through to the persisted items
+  EXPECT_TRUE(bl->PopFront(&value));
+  EXPECT_EQ(value, "-3");
+  EXPECT_TRUE(bl->PopBack(&value));
+  EXPECT_EQ(value, "9");
+  bl->PushFront("z");
+  bl->PushBack("w");
+  EXPECT_TRUE(bl->Flush());
+  EXPECT_EQ(pl->Front().second, "z");
+  EXPECT_EQ(pl->Back().second, "w");
+
+  // and to the other ring when the persisted list is empty
+  bl->Clear();
+  bl->PushBack("a");
+  bl->PushBack("b");
+  bl->PushFront("c");
+  EXPECT_TRUE(bl->PopBack(&value));
+  EXPECT_EQ(value, "b");
+  EXPECT_TRUE(bl->PopBack(&value));
+  EXPECT_EQ(value, "a");
+  EXPECT_TRUE(bl->PopBack(&value));
+  EXPECT_EQ(value, "c");
+  EXPECT_FALSE(bl->PopFront());
+  EXPECT_FALSE(bl->Front().first);
+
+  // the buffered items are written on release
+  bl->PushBack("kept");
+  bl.reset();
+  EXPECT_EQ(pl->Size(), 1);
+  EXPECT_EQ(pl->Front().second, "kept");
+  pl->Clear();
+
+  // time and size triggers
+  bl = BufferedPersistentList::Get(spDB, "bufferedlist", 1000, 20);
+  bl->PushBack("t");
+  this_thread::sleep_for(chrono::milliseconds(200));
+  EXPECT_EQ(bl->Buffered(), 0);
+  EXPECT_EQ(pl->Size(), 1);
+
+  bl = BufferedPersistentList::Get(spDB, "bufferedlist", 10, 3600000);
+  for (int i = 0; i < 10; i++)
+    bl->PushBack(to_string(i));
+  for (int i = 0; i < 100 && bl->Buffered() > 0; i++)
+    this_thread::sleep_for(chrono::milliseconds(10));
+  EXPECT_EQ(bl->Buffered(), 0);
+  EXPECT_EQ(pl->Size(), 11);
+  bl->Clear();
+}
+
+TEST_F(PersistentListTest, CheckStripedListMetadata) {
+  using namespace std;
+
+  // a striped list named after a list id stays out of that list
+  auto pl = PersistentList::Get(spDB, "stripedmeta");
+  pl->Clear();
+  auto sl = StripedPersistentList::Get(spDB, pl->Id(), 2);
+  EXPECT_EQ(sl->Stripes(), 2);
+  EXPECT_EQ(pl->Size(), 0);
+  EXPECT_FALSE(pl->Front().first);
+
+  // the stripe count moves from its old key
+  spDB->Put(writeOptions, "pl/oldstriped/stripes", "3");
+  sl = StripedPersistentList::Get(spDB, "oldstriped", 1);
+  EXPECT_EQ(sl->Stripes(), 3);
+  string value;
+  EXPECT_TRUE(spDB->Get(readOptions, "pl/oldstriped/stripes", &value)
+                  .IsNotFound());
+  EXPECT_EQ(StripedPersistentList::Get(spDB, "oldstriped", 1)->Stripes(), 3);
+}
+
+TEST_F(PersistentListTest, CheckDelayQueueInstances) {
+  using namespace std;
+
+  const int max_range = 2000;
+  auto dq1 = DelayQueue::Get(spDB, "sharedqueue");
+  auto dq2 = DelayQueue::Get(spDB, "sharedqueue");
+  dq1->List()->Clear();
+
+  // two instances pushing the same due time keep all the items
+  const uint64_t due = DelayQueue::Now();
+  auto pusher = [due](shared_ptr<DelayQueue> dq, int first) {
+    for (int i = first; i < first + max_range; i++)
+      dq->Push(to_string(i), due);
+  };
+  thread t1(pusher, dq1, 0), t2(pusher, dq2, max_range);
+  t1.join();
+  t2.join();
+  EXPECT_EQ(dq1->Size(), 2 * max_range);
+
+  // and each item is popped once
+  vector<string> popped1, popped2;
+  auto popper = [due](shared_ptr<DelayQueue> dq, vector<string> *popped) {
+    vector<string> values;
+    while (!(values = dq->PopDue(due, 10)).empty())
+      popped->insert(popped->end(), values.begin(), values.end());
+  };
+  thread t3(popper, dq1, &popped1), t4(popper, dq2, &popped2);
+  t3.join();
+  t4.join();
+
+  set<string> values(popped1.begin(), popped1.end());
+  values.insert(popped2.begin(), popped2.end());
+  EXPECT_EQ(popped1.size() + popped2.size(), 2 * max_range);
+  EXPECT_EQ(values.size(), 2 * max_range);
+  EXPECT_EQ(dq1->Size(), 0);
+}
+
+TEST_F(PersistentListTest, CheckDelayQueueReopen) {
+  using namespace std;
+
+  auto dq = DelayQueue::Get(spDB, "reopenqueue");
+  dq->List()->Clear();
+  const uint64_t due = DelayQueue::Now();
+  string key = dq->Push("first", due);
+  dq.reset();
+
+  // an item of an earlier run, whose tiebreak had grown further
+  const size_t dueKeyLen = key.length() - 8;
+  string stored = key.substr(0, dueKeyLen) + "xxxxxxxx";
+  spDB->Put(leveldb::WriteOptions(), stored, "stored");
+
+  // a reopened queue pushes the same due time after it, not over it
+  dq = DelayQueue::Get(spDB, "reopenqueue");
+  string next = dq->Push("next", due);
+  EXPECT_GT(next.compare(stored), 0);
+  EXPECT_EQ(next.substr(0, dueKeyLen), stored.substr(0, dueKeyLen));
+  EXPECT_EQ(dq->Size(), 3);
+
+  auto values = dq->PopDue(due, 10);
+  ASSERT_EQ(values.size(), 3);
+  EXPECT_EQ(values[0], "first");
+  EXPECT_EQ(values[1], "stored");
+  EXPECT_EQ(values[2], "next");
+}
+
+TEST_F(PersistentListTest, CheckListServerForeignKeys) {
+  using namespace std;
+
+  ListServer server(spDB, "./db.sock");
+  ASSERT_TRUE(server.Start());
+  auto client = ListClient::Connect("./db.sock");
+  auto rl = RemotePersistentList::Get(client, "keysa");
+  auto other = RemotePersistentList::Get(client, "keysb");
+  auto pl = PersistentList::Get(spDB, "keysa");
+
+  rl->Clear();
+  other->Clear();
+  rl->PushBack("a1");
+  auto otherKey = other->PushBack("b1");
+
+  const string prefix = "pl/" + pl->Id() + "/";
+  vector<string> badKeys = {otherKey,    prefix + "!", prefix + "~",
+                            prefix + "~~", "pl/0/~~",  "zzz",
+                            "pl/keysa/id", "pl/next_id", "a"};
+
+  for (auto &key : badKeys) {
+    string request(1, (char)ListProtocol::SCAN), response;
+    PutLengthPrefixed(&request, "keysa");
+    PutLengthPrefixed(&request, key);
+    PutVarint32(&request, 10);
+    ASSERT_TRUE(client->Call(request, &response)) << key;
+    EXPECT_EQ(response[0], ListProtocol::BAD_REQUEST) << key;
+
+    request.assign(1, (char)ListProtocol::POP_KEY);
+    PutLengthPrefixed(&request, "keysa");
+    PutLengthPrefixed(&request, key);
+    ASSERT_TRUE(client->Call(request, &response)) << key;
+    EXPECT_EQ(response[0], ListProtocol::BAD_REQUEST) << key;
+    EXPECT_FALSE(pl->PopKey(key)) << key;
+  }
+
+  // the list, its sentinels and the other list are untouched
+  EXPECT_EQ(rl->Size(), 1);
+  EXPECT_EQ(other->Size(), 1);
+  EXPECT_EQ(rl->Scan("", 10).size(), 1);
+  rl->Clear();
+  EXPECT_EQ(rl->Size(), 0);
+  EXPECT_EQ(other->Front().second, "b1");
+
+  // out of range seeks stop at the ends of the list
+  pl->PushBack("a2");
+  PersistentListIterator iter(pl);
+  EXPECT_FALSE(iter.Seek("zzz"));
+  EXPECT_FALSE(iter.Seek(otherKey));
+  EXPECT_TRUE(iter.Seek(""));
+  EXPECT_EQ(iter.Value(), "a2");
+  EXPECT_TRUE(iter.Seek("pl/"));
+  EXPECT_EQ(iter.Value(), "a2");
+
+  server.Stop();
+}
+
+TEST_F(PersistentListTest, CheckListServerMissingList) {
+  using namespace std;
+
+  ListServer server(spDB, "./db.sock");
+  ASSERT_TRUE(server.Start());
+  auto client = ListClient::Connect("./db.sock");
+  auto rl = RemotePersistentList::Get(client, "neverpushed");
+
+  // the reads, pops and bad requests answer as for an empty list
+  EXPECT_EQ(rl->Size(), 0);
+  EXPECT_FALSE(rl->Front().first);
+  EXPECT_FALSE(rl->Back().first);
+  EXPECT_FALSE(rl->PopFront());
+  EXPECT_TRUE(rl->PopFront(10).empty());
+  EXPECT_FALSE(rl->PopKey("pl/1/NNNNNNNN"));
+  EXPECT_FALSE(rl->PopValue("a"));
+  EXPECT_TRUE(rl->Scan("", 10).empty());
+  rl->Clear();
+
+  for (uint8_t op : {0, 15, 255}) {
+    string request(1, (char)op), response;
+    PutLengthPrefixed(&request, "neverpushed");
+    ASSERT_TRUE(client->Call(request, &response));
+    EXPECT_EQ(response[0], ListProtocol::BAD_REQUEST);
+  }
+  EXPECT_TRUE(PersistentList::GetExisting(spDB, "neverpushed") == nullptr);
+
+  // a push creates it
+  rl->PushBack("a");
+  auto pl = PersistentList::GetExisting(spDB, "neverpushed");
+  ASSERT_TRUE(pl != nullptr);
+  EXPECT_EQ(pl->Front().second, "a");
+
+  server.Stop();
+}
+
+TEST_F(PersistentListTest, CheckBatchPush) {
+  using namespace std;
+
+  auto pl = PersistentList::Get(spDB, "batchlist");
+  pl->Clear();
+  pl->PushBack("0");
+
+  vector<leveldb::Slice> values = {"1", "2", "3"};
+  auto keys = pl->PushBack(values);
+  ASSERT_EQ(keys.size(), 3);
+  EXPECT_EQ(pl->Size(), 4);
+  EXPECT_LT(keys[0], keys[1]);
+  EXPECT_EQ(pl->Back().second, "3");
+  EXPECT_TRUE(pl->PopKey(keys[1]));
+  EXPECT_EQ(pl->PushBack(vector<leveldb::Slice>()).size(), 0);
+
+  ListServer server(spDB, "./db.sock");
+  ASSERT_TRUE(server.Start());
+  auto client = ListClient::Connect("./db.sock");
+
+  // a batch cut short writes nothing
+  string request(1, (char)ListProtocol::PUSH_BACK_BATCH), response;
+  PutLengthPrefixed(&request, "batchlist");
+  PutVarint32(&request, 3);
+  PutLengthPrefixed(&request, "4");
+  PutLengthPrefixed(&request, "5");
+  ASSERT_TRUE(client->Call(request, &response));
+  EXPECT_EQ(response[0], ListProtocol::BAD_REQUEST);
+  EXPECT_EQ(pl->Size(), 3);
+
+  PutLengthPrefixed(&request, "6");
+  ASSERT_TRUE(client->Call(request, &response));
+  EXPECT_EQ(response[0], ListProtocol::OK);
+  EXPECT_EQ(pl->Size(), 6);
+  EXPECT_EQ(pl->Back().second, "6");
+  server.Stop();
+}
+
+TEST_F(PersistentListTest, CheckListServerWaitPushFront) {
+  using namespace std;
+
+  ListServer server(spDB, "./db.sock");
+  ASSERT_TRUE(server.Start());
+  auto rl = RemotePersistentList::Get(ListClient::Connect("./db.sock"),
+                                      "waitfront");
+  auto pl = PersistentList::Get(spDB, "waitfront");
+  rl->Clear();
+
+  // a push at the front wakes a blocked pop at once, not at the end of
+  // the server's (100 ms) wait slice
+  chrono::steady_clock::time_point pushed;
+  thread producer([&pl, &pushed] {
+    this_thread::sleep_for(chrono::milliseconds(10));
+    pushed = chrono::steady_clock::now();
+    pl->PushFront("front");
+  });
+  auto popped = rl->WaitPopFront(5000);
+  auto woken = chrono::steady_clock::now();
+  producer.join();
+
+  EXPECT_TRUE(popped.first);
+  EXPECT_EQ(popped.second, "front");
+  EXPECT_LT(chrono::duration_cast<chrono::milliseconds>(woken - pushed).count(),
+            50);
+  server.Stop();
+}
 
 TEST_F(PersistentListTest, CheckDB) {
   // leveldb::Iterator *iter = spDB->NewIterator(readOptions);